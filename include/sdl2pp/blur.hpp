@@ -0,0 +1,66 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include <cstddef>
+#include <optional>
+
+#include "enums.hpp"
+#include "shapes.hpp"
+#include "surface.hpp"
+
+namespace sdl2 {
+
+/**
+ * @brief How to blur.
+ */
+struct blur_options {
+    /**
+     * @brief The kernel. ITERATED_BOX approximates a Gaussian with box passes whose cost does not grow with the radius.
+     */
+    blur_filter filter = blur_filter::GAUSSIAN;
+
+    /**
+     * @brief The radius in pixels for BOX, the standard deviation for GAUSSIAN and ITERATED_BOX.
+     */
+    float radius = 2.0f;
+
+    /**
+     * @brief The number of box passes of ITERATED_BOX.
+     */
+    int iterations = 3;
+
+    /**
+     * @brief What is read past the edges of the region: its edge pixels, or transparent black.
+     */
+    blur_border border = blur_border::CLAMP;
+
+    /**
+     * @brief The number of threads to split the rows across.
+     */
+    std::size_t threads = 1;
+};
+
+/**
+ * @brief Blur a region of a surface in place.
+ * Each pass is separable: rows are filtered one at a time, then columns in strips a few cache lines wide
+ * so the rows a column kernel reads stay in cache. Box sums slide across the window; Gaussian taps are
+ * applied two at a time with SSE2 multiply-adds in 14-bit fixed point.
+ * @param s The surface. Its format must have 8-bit channels in 3 or 4 bytes (e.g. ARGB8888, RGB24).
+ * @param options How to blur.
+ * @param area The region to blur, clipped to the surface, or the whole surface if empty. Pixels outside it are not read.
+ * @return True if succeeded, false if the surface or format is unsupported.
+ */
+bool blur(surface& s, blur_options const& options, std::optional<rect<int>> area = std::nullopt);
+
+/**
+ * @brief Blur a region of a surface into the same region of another.
+ * @param src The surface to read. Its format must have 8-bit channels in 3 or 4 bytes.
+ * @param dst The surface to write, of the same size and format. Pixels outside the region are left as they are.
+ * @param options How to blur.
+ * @param area The region to blur, clipped to the surfaces, or the whole surface if empty.
+ * @return True if succeeded, false if the surfaces or formats are unsupported or do not match.
+ */
+bool blur(surface const& src, surface& dst, blur_options const& options, std::optional<rect<int>> area = std::nullopt);
+
+} // namespace sdl2
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "shapes.hpp"
+#include "surface.hpp"
+#include "util.hpp"
+#include "window.hpp"
+
+namespace sdl2 {
+
+/**
+ * @brief Accumulates the damaged areas of a surface so only those areas are pushed to the screen.
+ * Overlapping or nearby rects are coalesced into fewer, larger rects to keep the submitted list short.
+ */
+class dirty_region {
+    std::vector<rect<int>> rects_;
+    wh<int> bounds_;
+    std::size_t max_rects_;
+    float merge_waste_;
+    float full_update_ratio_;
+
+    void insert(rect<int> r) noexcept;
+    void collapse() noexcept;
+
+public:
+    /**
+     * @brief Construct a tracker for a surface of the given size.
+     * @param bounds The size of the tracked surface. Damage outside of it is discarded.
+     * @param max_rects The maximum number of rects to keep before forcing merges.
+     * @param merge_waste The maximum fraction of a merged rect allowed to be undamaged.
+     * @param full_update_ratio The fraction of the surface after which a full update is submitted instead.
+     */
+    explicit dirty_region(wh<int> bounds, std::size_t max_rects = 16,
+                          float merge_waste = 0.25f, float full_update_ratio = 0.75f);
+
+    /**
+     * @brief Construct a tracker for a window's surface, sized in pixels rather than screen coordinates.
+     * @param win The window whose surface is tracked. Its surface is created if it has none yet.
+     * @param max_rects The maximum number of rects to keep before forcing merges.
+     */
+    explicit dirty_region(window const& win, std::size_t max_rects = 16);
+
+    /**
+     * @brief Mark an area as damaged.
+     * @param r The damaged area.
+     */
+    void add(rect<int> const& r) noexcept;
+
+    /**
+     * @brief Mark the whole surface as damaged.
+     */
+    void add_all() noexcept;
+
+    /**
+     * @brief Blit a surface and mark the destination area as damaged.
+     * @param src The source surface.
+     * @param srcrect The area of the source to copy.
+     * @param dst The destination surface.
+     * @param dstrect The destination area. Updated with the clipped area that was written.
+     * @return True if succeeded, false if failed.
+     */
+    bool blit(surface& src, rect<int> const& srcrect, surface& dst, rect<int>& dstrect) noexcept;
+
+    /**
+     * @brief Blit an entire surface and mark the destination area as damaged.
+     * @param src The source surface.
+     * @param dst The destination surface.
+     * @param dstrect The destination area. Updated with the clipped area that was written.
+     * @return True if succeeded, false if failed.
+     */
+    bool blit(surface& src, surface& dst, rect<int>& dstrect) noexcept;
+
+    /**
+     * @brief Fill an area of a surface and mark it as damaged.
+     * @param dst The destination surface.
+     * @param r The area to fill.
+     * @param color The fill color.
+     * @return True if succeeded, false if failed.
+     */
+    bool fill_rect(surface& dst, rect<int> const& r, pixel_value color) noexcept;
+
+    /**
+     * @brief Copy the damaged areas of the window surface to the screen and reset the tracker.
+     * @param win The window to update.
+     * @return True if succeeded, false if failed.
+     * @note Nothing is submitted if no area is damaged.
+     */
+    bool flush(window& win) noexcept;
+
+    /**
+     * @brief Forget all damage.
+     */
+    void clear() noexcept { rects_.clear(); }
+
+    /**
+     * @brief Change the size of the tracked surface. All damage is discarded.
+     * @param bounds The new size.
+     */
+    void resize(wh<int> bounds) noexcept;
+
+    /**
+     * @brief Checks if any area is damaged.
+     * @return True if nothing is damaged, false if not.
+     */
+    bool empty() const noexcept { return rects_.empty(); }
+
+    /**
+     * @brief Get the current damaged areas.
+     * @return A span of the coalesced rects.
+     */
+    std::span<rect<int> const> rects() const noexcept { return rects_; }
+
+    /**
+     * @brief Get the total area covered by the damaged rects.
+     * @return The damaged area in pixels.
+     */
+    long long area() const noexcept;
+
+    /**
+     * @brief Checks if the damage is large enough that a full surface update is cheaper.
+     * @return True if a full update should be used, false if not.
+     */
+    bool prefers_full_update() const noexcept;
+};
+
+} // namespace sdl2
@@ -88,6 +88,80 @@ enum class blend_mode : int {
     MUL = SDL_BLENDMODE_MUL,
 };
 
+/**
+ * @brief Compositing operators for surface::composite: the Porter-Duff set plus separable blend modes.
+ */
+enum class composite_op : int {
+    CLEAR = 0,
+    SRC,
+    DST,
+    SRC_OVER,
+    DST_OVER,
+    SRC_IN,
+    DST_IN,
+    SRC_OUT,
+    DST_OUT,
+    SRC_ATOP,
+    DST_ATOP,
+    XOR,
+    PLUS,
+    MULTIPLY,
+    SCREEN,
+    OVERLAY,
+};
+
+/**
+ * @brief Whether color channels are stored as is (straight) or already multiplied by alpha.
+ */
+enum class alpha_format : int {
+    STRAIGHT = 0,
+    PREMULTIPLIED,
+};
+
+/**
+ * @brief The file layout written by a frame_sink.
+ */
+enum class frame_sink_format : int {
+    RAW_RGBA = 0,
+    Y4M,
+};
+
+/**
+ * @brief The filter a surface_pyramid downsamples each level with.
+ */
+enum class mip_filter : int {
+    BOX = 0,
+    KAISER,
+};
+
+/**
+ * @brief The kernel of a blur.
+ */
+enum class blur_filter : int {
+    BOX = 0,
+    ITERATED_BOX,
+    GAUSSIAN,
+};
+
+/**
+ * @brief What a blur reads past the edges of the blurred region.
+ */
+enum class blur_border : int {
+    CLAMP = 0,
+    ZERO,
+};
+
+/**
+ * @brief A channel of a surface_histogram.
+ */
+enum class histogram_channel : int {
+    R = 0,
+    G,
+    B,
+    A,
+    LUMA,
+};
+
  enum class fullscreen_flags : std::uint32_t { 
     WINDOWED = 0, 
     FULLSCREEN = SDL_WINDOW_FULLSCREEN, 
@@ -240,4 +314,22 @@ enum class renderer_flip {
     VERTICAL = SDL_FLIP_VERTICAL,
 };
 
+inline constexpr renderer_flip operator|(renderer_flip const& a, renderer_flip const& b) noexcept {
+    return static_cast<renderer_flip>(static_cast<int>(a) | static_cast<int>(b));
+}
+
+inline constexpr bool operator&(renderer_flip const& a, renderer_flip const& b) noexcept {
+    return static_cast<bool>(static_cast<int>(a) & static_cast<int>(b));
+}
+
+/**
+ * @brief A clockwise rotation by a multiple of 90 degrees.
+ */
+enum class rotation : int {
+    NONE = 0,
+    CW_90,
+    CW_180,
+    CW_270,
+};
+
 } // namespace sdl2
\ No newline at end of file
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "enums.hpp"
+#include "shapes.hpp"
+#include "texture.hpp"
+#include "util.hpp"
+
+namespace sdl2 {
+
+class renderer;
+
+/**
+ * @brief Captures rendered frames without stalling on the frame that was just drawn.
+ * Frames are drawn into a ring of TARGET textures. Each end_frame reads back the oldest texture in
+ * the ring instead of the newest one, so the GPU has normally finished with it and the read does not
+ * wait for the frame in flight. The read happens in the texture's own format. Converting to the
+ * caller's format runs on a worker thread while the next frame is drawn.
+ * @code
+ * frame_capture cap{r, r.output_size()};
+ * while (running) {
+ *     cap.begin_frame();
+ *     draw(r);
+ *     cap.wait();                  // the conversion started by the last end_frame is done
+ *     consume(buffers[i ^ 1]);
+ *     cap.end_frame(buffers[i].data(), pitch, pixel_format_enum::RGB24);
+ *     r.present();
+ *     i ^= 1;
+ * }
+ * @endcode
+ * @note All member functions must be called from the thread that owns the renderer. The capture must
+ *       be destroyed before its renderer.
+ */
+class frame_capture {
+    struct job {
+        std::byte const* src = nullptr;
+        int src_pitch = 0;
+        void* dst = nullptr;
+        int dst_pitch = 0;
+        std::uint32_t dst_format = 0;
+    };
+
+    renderer& renderer_;
+    std::vector<texture> targets_;
+    std::vector<std::byte> staging_[2];
+    wh<int> size_;
+    std::uint32_t format_;
+    int staging_pitch_;
+    std::size_t next_ = 0;
+    std::uint64_t frames_ = 0;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::optional<job> pending_;
+    bool busy_ = false;
+    bool ok_ = true;
+    bool stop_ = false;
+    std::thread worker_;
+
+    void run() noexcept;
+
+public:
+    /**
+     * @brief Create the ring of render targets and start the conversion thread.
+     * @param r The renderer frames are drawn with.
+     * @param size The size of a frame in pixels.
+     * @param depth The number of textures in the ring, at least 2. end_frame returns frame n - depth + 1.
+     * @param format The format of the render targets. The default matches most GPU back buffers.
+     */
+    frame_capture(renderer& r, wh<int> size, std::size_t depth = 3, pixel_format_enum format = pixel_format_enum::ARGB8888);
+
+    frame_capture(frame_capture const&) = delete;
+    frame_capture& operator=(frame_capture const&) = delete;
+
+    /**
+     * @brief The destructor. Waits for the conversion in progress, then stops the worker thread.
+     */
+    ~frame_capture() noexcept;
+
+    /**
+     * @brief Checks if every render target was created.
+     * @return True if valid, false if not.
+     */
+    explicit operator bool() const noexcept { return !targets_.empty(); }
+
+    /**
+     * @brief Get the size of a frame.
+     * @return The size in pixels.
+     */
+    wh<int> size() const noexcept { return size_; }
+
+    /**
+     * @brief Get the number of frames begun so far.
+     * @return The frame count.
+     */
+    std::uint64_t frames() const noexcept { return frames_; }
+
+    /**
+     * @brief Make the next texture in the ring the render target.
+     * @return True if succeeded, false if failed.
+     */
+    bool begin_frame() noexcept;
+
+    /**
+     * @brief Get the texture being drawn this frame, e.g. to copy it to the window.
+     * @return The current render target.
+     */
+    texture const& current() const noexcept { return targets_[next_]; }
+
+    /**
+     * @brief Restore the default render target, show the frame on it and start capturing an older frame.
+     * Once the ring has filled, the oldest frame is read back and converted into pixels asynchronously.
+     * pixels must not be read or freed until wait() returns. If fmt matches the render targets, the
+     * pixels are read straight into the buffer and no conversion is queued.
+     * @param pixels The caller's buffer for a whole frame.
+     * @param pitch The pitch of the caller's buffer.
+     * @param fmt The format the caller wants.
+     * @return The index of the frame that will land in pixels, counting from 0, or an empty optional
+     *         if the ring has not filled yet or the read failed.
+     */
+    std::optional<std::uint64_t> end_frame(void* pixels, int pitch, pixel_format_enum fmt) noexcept;
+
+    /**
+     * @brief Block until the conversion queued by the last end_frame has finished.
+     * @return True if every conversion succeeded since the last call, false if one failed.
+     */
+    bool wait() noexcept;
+};
+
+} // namespace sdl2
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "enums.hpp"
+#include "shapes.hpp"
+#include "surface.hpp"
+#include "util.hpp"
+
+namespace sdl2 {
+
+/**
+ * @brief Convert a surface to planar YUV 4:2:0, the layout texture::update_yuv consumes for IYUV.
+ * Uses BT.601 limited range. Each chroma sample is the average of a 2x2 block centred between its
+ * pixels; odd edges repeat the last row or column.
+ * @param s The surface to convert. Palettized and FOURCC surfaces are not supported.
+ * @param yplane The Y plane, at least ypitch * height bytes.
+ * @param ypitch Number of bytes between rows of the Y plane.
+ * @param uplane The U plane, at least upitch * ceil(height / 2) bytes.
+ * @param upitch Number of bytes between rows of the U plane.
+ * @param vplane The V plane, at least vpitch * ceil(height / 2) bytes.
+ * @param vpitch Number of bytes between rows of the V plane.
+ * @return True if succeeded, false if the format is unsupported or a plane is too small.
+ */
+bool rgb_to_yuv420(surface const& s,
+                   std::span<std::byte> yplane, int ypitch,
+                   std::span<std::byte> uplane, int upitch,
+                   std::span<std::byte> vplane, int vpitch) noexcept;
+
+/**
+ * @brief Streams frames of a fixed size to a raw RGBA or Y4M file.
+ * The calling thread converts each frame into one of a fixed number of buffers and a writer thread
+ * writes them to disk, so memory is bounded and write only waits for the disk when every buffer is
+ * queued. To capture a software renderer, pass the surface it was created with after each frame.
+ * @note Not thread safe: write must be called from one thread at a time.
+ */
+class frame_sink {
+    SDL_RWops* file_;
+    wh<int> size_;
+    frame_sink_format format_;
+    std::size_t frame_bytes_;
+    std::vector<std::vector<std::byte>> buffers_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::uint64_t submitted_ = 0;
+    std::uint64_t written_ = 0;
+    bool failed_ = false;
+    bool stop_ = false;
+    std::thread writer_;
+
+    void run() noexcept;
+    bool convert(surface const& s, std::byte* dst) noexcept;
+
+public:
+    /**
+     * @brief Open the file, write its header and start the writer thread.
+     * @param file The path of the file to create or truncate.
+     * @param size The size of every frame in pixels.
+     * @param format Whether to write raw RGBA32 frames or a YUV 4:2:0 Y4M stream.
+     * @param fps The frame rate recorded in the Y4M header.
+     * @param queue_depth The number of converted frames that may wait for the disk.
+     */
+    frame_sink(null_term_string file, wh<int> size, frame_sink_format format, int fps = 60, std::size_t queue_depth = 4);
+
+    frame_sink(frame_sink const&) = delete;
+    frame_sink& operator=(frame_sink const&) = delete;
+
+    /**
+     * @brief The destructor. Writes every queued frame, then closes the file.
+     */
+    ~frame_sink() noexcept;
+
+    /**
+     * @brief Checks if the file is open and no write has failed.
+     * @return True if valid, false if not.
+     */
+    explicit operator bool() const noexcept;
+
+    /**
+     * @brief Queue a frame for writing.
+     * @param s The frame, which must have the sink's size. It is converted before write returns.
+     * @return True if the frame was queued, false if the surface is unsuitable or a write failed.
+     */
+    bool write(surface const& s) noexcept;
+
+    /**
+     * @brief Block until every queued frame is on disk.
+     * @return True if every write succeeded, false if one failed.
+     */
+    bool flush() noexcept;
+
+    /**
+     * @brief Get the number of frames written to the file so far.
+     * @return The frame count.
+     */
+    std::uint64_t frames_written() const noexcept;
+};
+
+} // namespace sdl2
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "color.hpp"
+#include "shapes.hpp"
+#include "texture.hpp"
+#include "util.hpp"
+
+namespace sdl2 {
+
+class renderer;
+
+/**
+ * @brief The placement of one glyph relative to the pen.
+ */
+struct glyph_metrics {
+    /**
+     * @brief The size of the glyph's bitmap.
+     */
+    wh<int> size{};
+
+    /**
+     * @brief The offset from the pen position on the baseline to the bitmap's top-left corner.
+     */
+    point<int> bearing{};
+
+    /**
+     * @brief How far the pen moves after the glyph.
+     */
+    int advance = 0;
+};
+
+/**
+ * @brief Turns code points into coverage bitmaps for a glyph_cache.
+ * Implement it to back the cache with a font library; bitmap_font works without one.
+ */
+class glyph_rasterizer {
+public:
+    virtual ~glyph_rasterizer() = default;
+
+    /**
+     * @brief Get the distance from the top of a line to its baseline.
+     * @return The ascent in pixels.
+     */
+    virtual int ascent() const noexcept = 0;
+
+    /**
+     * @brief Get the distance between the baselines of consecutive lines.
+     * @return The line height in pixels.
+     */
+    virtual int line_height() const noexcept = 0;
+
+    /**
+     * @brief Get the placement of a glyph.
+     * @param cp The code point.
+     * @return The metrics, or an empty optional if the font has no glyph for cp.
+     */
+    virtual std::optional<glyph_metrics> metrics(char32_t cp) const noexcept = 0;
+
+    /**
+     * @brief Draw a glyph as 8-bit coverage.
+     * @param cp The code point, one for which metrics returned a value.
+     * @param coverage Receives metrics(cp)->size pixels, 0 for empty through 255 for covered.
+     * @param pitch Number of bytes between rows of coverage.
+     * @return True if succeeded, false if failed.
+     */
+    virtual bool rasterize(char32_t cp, std::span<std::uint8_t> coverage, int pitch) const noexcept = 0;
+
+    /**
+     * @brief Get the adjustment to the advance between two glyphs.
+     * @param left The code point before the pen.
+     * @param right The code point after the pen.
+     * @return The adjustment in pixels, 0 by default.
+     */
+    virtual int kerning([[maybe_unused]] char32_t left, [[maybe_unused]] char32_t right) const noexcept { return 0; }
+};
+
+/**
+ * @brief A built-in monospaced 8x8 font covering printable ASCII, for use without any font files.
+ */
+class bitmap_font final : public glyph_rasterizer {
+    int scale_;
+
+public:
+    /**
+     * @brief Construct the font.
+     * @param scale The integer factor every glyph is enlarged by.
+     */
+    explicit bitmap_font(int scale = 1) noexcept;
+
+    int ascent() const noexcept override;
+    int line_height() const noexcept override;
+    std::optional<glyph_metrics> metrics(char32_t cp) const noexcept override;
+    bool rasterize(char32_t cp, std::span<std::uint8_t> coverage, int pitch) const noexcept override;
+};
+
+/**
+ * @brief Caches rasterized glyphs in one texture and draws whole strings with a single geometry call.
+ * Glyphs are packed into the atlas on first use. When it fills up, the atlas is emptied and refilled
+ * with the glyphs still being drawn. Glyphs are white in the atlas and tinted per string by vertex color.
+ * @note Not thread safe. The rasterizer must outlive the cache, and the cache must be destroyed before its renderer.
+ */
+class glyph_cache {
+    struct glyph {
+        rect<int> src;
+        glyph_metrics metrics;
+    };
+
+    renderer& renderer_;
+    glyph_rasterizer const& rasterizer_;
+    texture atlas_;
+    wh<int> atlas_size_;
+    std::unordered_map<char32_t, glyph> glyphs_;
+    int shelf_x_ = 0;
+    int shelf_y_ = 0;
+    int shelf_h_ = 0;
+    std::uint64_t generation_ = 0;
+    std::vector<std::uint8_t> coverage_;
+    std::vector<std::uint32_t> upload_;
+    std::vector<SDL_Vertex> vertices_;
+    std::vector<int> indices_;
+
+    glyph const* find(char32_t cp);
+    glyph const* insert(char32_t cp, glyph_metrics const& m);
+    void build(std::string_view utf8, point<float> pos, SDL_Color color);
+
+public:
+    /**
+     * @brief Create the atlas texture.
+     * @param r The renderer text is drawn with.
+     * @param rasterizer The source of glyphs.
+     * @param atlas_size The size of the atlas texture.
+     */
+    glyph_cache(renderer& r, glyph_rasterizer const& rasterizer, wh<int> atlas_size = {512, 512});
+
+    glyph_cache(glyph_cache const&) = delete;
+    glyph_cache& operator=(glyph_cache const&) = delete;
+
+    /**
+     * @brief Checks if the atlas texture was created.
+     * @return True if valid, false if not.
+     */
+    explicit operator bool() const noexcept { return static_cast<bool>(atlas_); }
+
+    /**
+     * @brief Get the atlas texture, e.g. to inspect it while debugging.
+     * @return The atlas.
+     */
+    texture const& atlas() const noexcept { return atlas_; }
+
+    /**
+     * @brief Rasterize glyphs ahead of time so drawing them later uploads nothing.
+     * @param utf8 The characters to cache, in UTF-8.
+     */
+    void preload(std::string_view utf8);
+
+    /**
+     * @brief Get the size of the box a string occupies when drawn.
+     * @param utf8 The text in UTF-8. '\n' starts a new line.
+     * @return The width of the widest line and the height of all lines.
+     */
+    wh<int> measure(std::string_view utf8);
+
+    /**
+     * @brief Draw a string left to right with one call to the renderer.
+     * @param utf8 The text in UTF-8. '\n' starts a new line; characters the font lacks are drawn as '?'.
+     * @param pos The top-left corner of the first line.
+     * @param color The color the glyphs are tinted with.
+     * @return True if succeeded, false if the renderer failed or the string's glyphs do not fit in the atlas together.
+     */
+    bool draw_text(std::string_view utf8, point<float> pos, rgba<> color = colors::white);
+
+    /**
+     * @brief Forget every cached glyph and fill the atlas with transparent texels.
+     */
+    void clear() noexcept;
+};
+
+} // namespace sdl2
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "enums.hpp"
+#include "shapes.hpp"
+#include "surface.hpp"
+
+namespace sdl2 {
+
+/**
+ * @brief The range and moments of one channel.
+ */
+struct channel_statistics {
+    std::uint8_t min = 0;
+    std::uint8_t max = 0;
+    double mean = 0.0;
+    double variance = 0.0;
+};
+
+/**
+ * @brief 256-bin histograms of the red, green, blue, alpha and luma channels of a surface, and their statistics.
+ * Luma is the rounded BT.601 weighting (77 R + 150 G + 29 B) / 256. Formats without alpha count every pixel as opaque.
+ */
+struct surface_histogram {
+    /**
+     * @brief The number of pixels counted.
+     */
+    std::size_t pixels = 0;
+
+    /**
+     * @brief The bins of each channel, indexed by histogram_channel.
+     */
+    std::array<std::array<std::uint64_t, 256>, 5> bins{};
+
+    /**
+     * @brief The statistics of each channel, indexed by histogram_channel.
+     */
+    std::array<channel_statistics, 5> stats{};
+
+    /**
+     * @brief Get the bins of a channel.
+     * @param c The channel.
+     * @return The 256 bins, indexed by channel value.
+     */
+    std::array<std::uint64_t, 256> const& operator[](histogram_channel const c) const noexcept {
+        return bins[static_cast<std::size_t>(c)];
+    }
+
+    /**
+     * @brief Get the statistics of a channel.
+     * @param c The channel.
+     * @return The range and moments of the channel.
+     */
+    channel_statistics const& statistics(histogram_channel const c) const noexcept {
+        return stats[static_cast<std::size_t>(c)];
+    }
+
+    /**
+     * @brief Get the smallest value that at least a fraction of the pixels do not exceed, e.g. 0.99 for the
+     * 99th percentile of luma when picking an exposure.
+     * @param c The channel.
+     * @param fraction The fraction of pixels, clamped to [0, 1].
+     * @return The value, or 0 if no pixels were counted.
+     */
+    std::uint8_t percentile(histogram_channel c, double fraction) const noexcept;
+};
+
+/**
+ * @brief Build the histograms and statistics of a surface in one pass over its pixels.
+ * Luma is computed 4 pixels at a time with SSE2 for 4-byte formats, and rows are split across threads,
+ * each filling its own bins. Formats without 8-bit channels are converted to ARGB8888 first.
+ * @param s The surface.
+ * @param area The region to count, clipped to the surface, or the whole surface if empty.
+ * @param threads The number of threads to use.
+ * @return The histograms, or an empty optional if the surface is invalid or the region is empty.
+ */
+std::optional<surface_histogram> compute_histogram(surface const& s, std::optional<rect<int>> area = std::nullopt, std::size_t threads = 1);
+
+} // namespace sdl2
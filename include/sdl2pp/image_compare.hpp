@@ -0,0 +1,106 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+
+#include "surface.hpp"
+#include "util.hpp"
+
+namespace sdl2 {
+
+/**
+ * @brief What compare_images computes besides the error statistics.
+ */
+struct compare_options {
+    /**
+     * @brief Compare alpha too. Ignored unless both surfaces have an alpha channel.
+     */
+    bool alpha = true;
+
+    /**
+     * @brief Compute the mean SSIM of the luma of both images.
+     */
+    bool ssim = false;
+
+    /**
+     * @brief The width and height of the SSIM window, which moves by half its size.
+     */
+    int ssim_window = 8;
+
+    /**
+     * @brief Produce an RGBA32 surface that is opaque white where pixels differ and transparent elsewhere.
+     */
+    bool mask = false;
+
+    /**
+     * @brief Produce an opaque RGBA32 surface going from black through red and yellow to white as a pixel's largest channel error grows.
+     */
+    bool heatmap = false;
+
+    /**
+     * @brief The number of threads to split the rows across.
+     */
+    std::size_t threads = 1;
+};
+
+/**
+ * @brief The result of compare_images.
+ */
+struct image_difference {
+    /**
+     * @brief The number of pixels with any compared channel different.
+     */
+    std::size_t differing_pixels = 0;
+
+    /**
+     * @brief The largest absolute difference of any channel.
+     */
+    int max_error = 0;
+
+    /**
+     * @brief The mean absolute difference over every compared channel.
+     */
+    double mean_error = 0.0;
+
+    /**
+     * @brief The mean squared difference over every compared channel.
+     */
+    double mse = 0.0;
+
+    /**
+     * @brief The peak signal-to-noise ratio in dB, infinite for identical images.
+     */
+    double psnr = std::numeric_limits<double>::infinity();
+
+    /**
+     * @brief The mean SSIM in [-1, 1], 1 for identical images. Only computed if requested.
+     */
+    std::optional<double> ssim;
+
+    /**
+     * @brief The difference mask, if requested.
+     */
+    std::optional<surface> mask;
+
+    /**
+     * @brief The error heatmap, if requested.
+     */
+    std::optional<surface> heatmap;
+};
+
+/**
+ * @brief Compare two images of the same size, e.g. a rendered frame against a reference screenshot.
+ * Surfaces in the same 4-byte format are compared 4 pixels at a time with SSE2 unless a mask or heatmap is requested;
+ * other formats are compared channel by channel, converting those without 8-bit channels to ARGB8888 first.
+ * @param a The first image.
+ * @param b The second image.
+ * @param options What to compute.
+ * @return The differences, or an empty optional if a surface is invalid, the sizes differ or an output surface could not be created.
+ */
+std::optional<image_difference> compare_images(surface const& a, surface const& b, compare_options const& options = {});
+
+} // namespace sdl2
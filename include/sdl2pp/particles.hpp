@@ -0,0 +1,128 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "color.hpp"
+#include "shapes.hpp"
+#include "texture.hpp"
+#include "util.hpp"
+
+namespace sdl2 {
+
+class renderer;
+
+/**
+ * @brief The initial state of a particle.
+ */
+struct particle {
+    /**
+     * @brief The center of the particle.
+     */
+    xy<float> position{};
+
+    /**
+     * @brief The velocity in pixels per second.
+     */
+    xy<float> velocity{};
+
+    /**
+     * @brief The color the texture is tinted with. Alpha fades linearly to 0 over the particle's life.
+     */
+    rgba<> color = colors::white;
+
+    /**
+     * @brief How long the particle lives in seconds.
+     */
+    float life = 1.0f;
+
+    /**
+     * @brief The width and height of the particle in pixels.
+     */
+    float size = 4.0f;
+};
+
+/**
+ * @brief A pool of particles sharing one texture, stored as structure-of-arrays and drawn with one geometry call.
+ * update() and the vertex build in draw() are straight loops over the separate arrays so they vectorise,
+ * and both can split the particles across threads.
+ * @note Not thread safe. The texture must outlive the emitter.
+ */
+class particle_emitter {
+    texture const& texture_;
+    rect<float> uv_;
+    std::size_t capacity_;
+    std::size_t count_ = 0;
+
+    std::vector<float> x_, y_, vx_, vy_, life_, inv_life_, sizes_;
+    std::vector<SDL_Color> color_;
+
+    std::vector<SDL_Vertex> vertices_;
+    std::vector<int> indices_;
+
+public:
+    /**
+     * @brief Allocate storage for every particle, vertex and index up front.
+     * @param txr The texture every particle is drawn with.
+     * @param capacity The most particles alive at once.
+     * @param src The area of the texture to draw, or the whole texture if empty.
+     */
+    particle_emitter(texture const& txr, std::size_t capacity, std::optional<rect<int>> src = {});
+
+    particle_emitter(particle_emitter const&) = delete;
+    particle_emitter& operator=(particle_emitter const&) = delete;
+
+    /**
+     * @brief Get the number of live particles.
+     * @return The particle count.
+     */
+    std::size_t size() const noexcept { return count_; }
+
+    /**
+     * @brief Get the most particles alive at once.
+     * @return The capacity.
+     */
+    std::size_t capacity() const noexcept { return capacity_; }
+
+    /**
+     * @brief Add a particle.
+     * @param p The particle's initial state.
+     * @return True if added, false if the emitter is full or the life is not positive.
+     */
+    bool emit(particle const& p) noexcept;
+
+    /**
+     * @brief Add many particles.
+     * @param ps The particles' initial states.
+     * @return The number added before the emitter filled up.
+     */
+    std::size_t emit(std::span<particle const> ps) noexcept;
+
+    /**
+     * @brief Remove every particle.
+     */
+    void clear() noexcept { count_ = 0; }
+
+    /**
+     * @brief Advance every particle and remove the ones whose life ran out.
+     * @param dt The time step in seconds.
+     * @param acceleration Added to every velocity, e.g. gravity, in pixels per second squared.
+     * @param threads The number of threads to integrate with. Small emitters always use one.
+     * @note Removing particles moves the last ones into their slots, so order is not preserved.
+     */
+    void update(float dt, xy<float> acceleration = {}, std::size_t threads = 1);
+
+    /**
+     * @brief Build a textured quad per particle and submit them all in one call.
+     * @param r The renderer to draw with.
+     * @param threads The number of threads to build vertices with. Small emitters always use one.
+     * @return True if succeeded, false if failed.
+     */
+    bool draw(renderer& r, std::size_t threads = 1);
+};
+
+} // namespace sdl2
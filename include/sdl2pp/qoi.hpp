@@ -0,0 +1,75 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "surface.hpp"
+#include "util.hpp"
+
+namespace sdl2 {
+
+/**
+ * @brief Encode a surface as a QOI image, a simple lossless format that encodes and decodes many times faster than PNG.
+ * Formats with an alpha channel are written with 4 channels, the rest with 3.
+ * @param s The surface to encode. Formats without 8-bit channels are converted first.
+ * @return The encoded image, or nothing if the surface is invalid or too large for QOI.
+ */
+std::vector<std::byte> qoi_encode(surface const& s);
+
+/**
+ * @brief Encode a surface as a QOI image into a stream, writing it in chunks rather than buffering the whole image.
+ * @param s The surface to encode.
+ * @param dst The stream to write to, at its current position.
+ * @return True if succeeded, false if failed.
+ */
+bool qoi_encode(surface const& s, SDL_RWops& dst);
+
+/**
+ * @brief Encode a surface as a QOI file.
+ * @param s The surface to encode.
+ * @param file The path of the file.
+ * @return True if succeeded, false if failed.
+ */
+bool qoi_save(surface const& s, null_term_string file);
+
+/**
+ * @brief Decode a QOI image.
+ * @param data The encoded image.
+ * @return An RGBA32 surface for 4-channel images or an RGB24 surface for 3-channel ones; invalid if the data is malformed.
+ */
+surface qoi_decode(std::span<std::byte const> data);
+
+/**
+ * @brief Decode a QOI image from a stream, reading it to the end.
+ * @param src The stream to read from, at its current position.
+ * @return The surface, invalid if failed.
+ */
+surface qoi_decode(SDL_RWops& src);
+
+/**
+ * @brief Decode a QOI file.
+ * @param file The path of the file.
+ * @return The surface, invalid if failed.
+ */
+surface qoi_load(null_term_string file);
+
+/**
+ * @brief Encode many surfaces at once, one per thread at a time.
+ * @param images The surfaces to encode. Each must appear once and not be used elsewhere until the call returns.
+ * @param threads The number of threads to use.
+ * @return The encoded images in the same order, each empty if that surface failed.
+ */
+std::vector<std::vector<std::byte>> qoi_encode_batch(std::span<surface const* const> images, std::size_t threads);
+
+/**
+ * @brief Decode many QOI images at once, one per thread at a time.
+ * @param images The encoded images.
+ * @param threads The number of threads to use.
+ * @return The surfaces in the same order, each invalid if that image failed.
+ */
+std::vector<surface> qoi_decode_batch(std::span<std::span<std::byte const> const> images, std::size_t threads);
+
+} // namespace sdl2
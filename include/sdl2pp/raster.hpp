@@ -0,0 +1,91 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include <span>
+
+#include "shapes.hpp"
+#include "surface.hpp"
+#include "util.hpp"
+
+namespace sdl2 {
+
+/**
+ * Software rasterisation of anti-aliased primitives directly into a surface's pixels.
+ * Colors are straight alpha and are blended over the existing contents. Drawing is limited to the
+ * surface's clip rect. Any 8, 16, 24 or 32-bit non-FOURCC format is supported; formats whose
+ * channels are whole bytes (e.g. RGBA8888, BGR24) take the fast paths.
+ */
+
+/**
+ * @brief Draw a one pixel wide anti-aliased line (Xiaolin Wu's algorithm).
+ * @param s The surface to draw into.
+ * @param from The start point.
+ * @param to The end point.
+ * @param color The line color.
+ * @return True if succeeded, false if the surface's format is not supported.
+ */
+bool draw_line(surface& s, point<float> const& from, point<float> const& to, rgba<> color) noexcept;
+
+/**
+ * @brief Draw a series of connected anti-aliased lines.
+ * @param s The surface to draw into.
+ * @param points The points along the line.
+ * @param thickness The line width in pixels. Widths above one are drawn with round joins and butt ends.
+ * @param color The line color.
+ * @return True if succeeded, false if the surface's format is not supported.
+ */
+bool draw_polyline(surface& s, std::span<point<float> const> points, float thickness, rgba<> color);
+
+/**
+ * @brief Fill an anti-aliased polygon using the non-zero winding rule.
+ * @param s The surface to draw into.
+ * @param points The polygon's vertices. The polygon is implicitly closed.
+ * @param color The fill color.
+ * @return True if succeeded, false if the surface's format is not supported.
+ */
+bool fill_polygon(surface& s, std::span<point<float> const> points, rgba<> color);
+
+/**
+ * @brief Fill an anti-aliased circle.
+ * @param s The surface to draw into.
+ * @param center The center of the circle.
+ * @param radius The radius in pixels.
+ * @param color The fill color.
+ * @return True if succeeded, false if the surface's format is not supported.
+ */
+bool fill_circle(surface& s, point<float> const& center, float radius, rgba<> color);
+
+/**
+ * @brief Draw the outline of an anti-aliased circle.
+ * @param s The surface to draw into.
+ * @param center The center of the circle.
+ * @param radius The radius in pixels, measured to the middle of the outline.
+ * @param thickness The outline width in pixels.
+ * @param color The outline color.
+ * @return True if succeeded, false if the surface's format is not supported.
+ */
+bool draw_circle(surface& s, point<float> const& center, float radius, float thickness, rgba<> color);
+
+/**
+ * @brief Fill an anti-aliased axis-aligned ellipse.
+ * @param s The surface to draw into.
+ * @param center The center of the ellipse.
+ * @param radii The horizontal(x) and vertical(y) radii in pixels.
+ * @param color The fill color.
+ * @return True if succeeded, false if the surface's format is not supported.
+ */
+bool fill_ellipse(surface& s, point<float> const& center, xy<float> radii, rgba<> color);
+
+/**
+ * @brief Draw the outline of an anti-aliased axis-aligned ellipse.
+ * @param s The surface to draw into.
+ * @param center The center of the ellipse.
+ * @param radii The horizontal(x) and vertical(y) radii in pixels, measured to the middle of the outline.
+ * @param thickness The outline width in pixels.
+ * @param color The outline color.
+ * @return True if succeeded, false if the surface's format is not supported.
+ */
+bool draw_ellipse(surface& s, point<float> const& center, xy<float> radii, float thickness, rgba<> color);
+
+} // namespace sdl2
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+#include "shapes.hpp"
+
+namespace sdl2 {
+
+/**
+ * @brief Clip many rects against one rect.
+ * @param rects The rects to clip.
+ * @param clip The clipping area.
+ * @param out Receives the clipped rects, or an all-zero rect where there is no overlap. May alias rects.
+ * @return The number of non-empty clipped rects.
+ * @note out must be at least as large as rects.
+ */
+std::size_t intersect_rects(std::span<rect<int> const> rects, rect<int> const& clip, std::span<rect<int>> out) noexcept;
+
+/**
+ * @brief Clip many rects against one rect.
+ * @param rects The rects to clip.
+ * @param clip The clipping area.
+ * @param out Receives the clipped rects, or an all-zero rect where there is no overlap. May alias rects.
+ * @return The number of non-empty clipped rects.
+ * @note out must be at least as large as rects.
+ */
+std::size_t intersect_rects(std::span<rect<float> const> rects, rect<float> const& clip, std::span<rect<float>> out) noexcept;
+
+/**
+ * @brief Find the rects that overlap an area.
+ * @param rects The rects to test.
+ * @param area The area to test against.
+ * @param indices Receives the indices of the overlapping rects in ascending order.
+ * @return The number of indices written.
+ * @note indices must be at least as large as rects.
+ */
+std::size_t cull_rects(std::span<rect<int> const> rects, rect<int> const& area, std::span<std::uint32_t> indices) noexcept;
+
+/**
+ * @brief Find the rects that overlap an area.
+ * @param rects The rects to test.
+ * @param area The area to test against.
+ * @param indices Receives the indices of the overlapping rects in ascending order.
+ * @return The number of indices written.
+ * @note indices must be at least as large as rects.
+ */
+std::size_t cull_rects(std::span<rect<float> const> rects, rect<float> const& area, std::span<std::uint32_t> indices) noexcept;
+
+/**
+ * @brief Find the top-most rect containing a point.
+ * @param rects The rects to test, ordered bottom to top.
+ * @param p The point to test.
+ * @return The index of the last rect containing p, or an empty optional if none do.
+ */
+std::optional<std::size_t> hit_test(std::span<rect<int> const> rects, point<int> const& p) noexcept;
+
+/**
+ * @brief Find the top-most rect containing a point.
+ * @param rects The rects to test, ordered bottom to top.
+ * @param p The point to test.
+ * @return The index of the last rect containing p, or an empty optional if none do.
+ */
+std::optional<std::size_t> hit_test(std::span<rect<float> const> rects, point<float> const& p) noexcept;
+
+/**
+ * @brief Test many points against one rect.
+ * @param r The rect to test against.
+ * @param points The points to test.
+ * @param inside Receives true for every point inside r.
+ * @return The number of points inside r.
+ * @note inside must be at least as large as points.
+ */
+std::size_t contains_points(rect<int> const& r, std::span<point<int> const> points, std::span<bool> inside) noexcept;
+
+/**
+ * @brief Test many points against one rect.
+ * @param r The rect to test against.
+ * @param points The points to test.
+ * @param inside Receives true for every point inside r.
+ * @return The number of points inside r.
+ * @note inside must be at least as large as points.
+ */
+std::size_t contains_points(rect<float> const& r, std::span<point<float> const> points, std::span<bool> inside) noexcept;
+
+/**
+ * @brief Compute the smallest rect containing every non-empty rect.
+ * @param rects The rects to unite.
+ * @return The bounding rect, or an empty optional if every rect is empty.
+ */
+std::optional<rect<int>> union_rects(std::span<rect<int> const> rects) noexcept;
+
+/**
+ * @brief Compute the smallest rect containing every non-empty rect.
+ * @param rects The rects to unite.
+ * @return The bounding rect, or an empty optional if every rect is empty.
+ */
+std::optional<rect<float>> union_rects(std::span<rect<float> const> rects) noexcept;
+
+} // namespace sdl2
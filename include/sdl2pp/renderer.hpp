@@ -381,6 +381,23 @@ public:
     template<class Rep>
     bool fill_rects(std::span<rect<Rep> const> rs) noexcept;
 
+    /**
+     * @brief Render textured triangles in a single call.
+     * @param txr The texture the vertices' texture coordinates refer to.
+     * @param vertices The vertices, with normalized texture coordinates and a color that modulates the texture.
+     * @param indices Three indices into vertices per triangle, or empty to take vertices three at a time.
+     * @return True if succeeded, false if failed.
+     */
+    bool render_geometry(texture const& txr, std::span<SDL_Vertex const> vertices, std::span<int const> indices = {}) noexcept;
+
+    /**
+     * @brief Render colored triangles in a single call.
+     * @param vertices The vertices. Texture coordinates are ignored.
+     * @param indices Three indices into vertices per triangle, or empty to take vertices three at a time.
+     * @return True if succeeded, false if failed.
+     */
+    bool render_geometry(std::span<SDL_Vertex const> vertices, std::span<int const> indices = {}) noexcept;
+
     /**
      * @brief Get the clipping rectange for the current target. 
      * @return The clipping area or an empty rectangle if clipping is disabled.
@@ -597,9 +614,9 @@ bool renderer::draw_rect(rect<Rep> const& r) noexcept {
 template<class Rep>
 bool renderer::draw_rects(std::span<rect<Rep> const> const r) noexcept {
     if constexpr (std::is_same_v<Rep, int>)
-        return SDL_RenderDrawRects(renderer_, r.data().native_handle(), static_cast<int>(r.size())) == 0;
+        return SDL_RenderDrawRects(renderer_, r.data()->native_handle(), static_cast<int>(r.size())) == 0;
     else
-        return SDL_RenderDrawRectsF(renderer_, r.data().native_handle(), static_cast<int>(r.size())) == 0;
+        return SDL_RenderDrawRectsF(renderer_, r.data()->native_handle(), static_cast<int>(r.size())) == 0;
 }
 
 template<class Rep>
@@ -613,9 +630,9 @@ bool renderer::fill_rect(rect<Rep> const& r) noexcept {
 template<class Rep>
 bool renderer::fill_rects(std::span<rect<Rep> const> const r) noexcept {
     if constexpr (std::is_same_v<Rep, int>)
-        return SDL_RenderFillRects(renderer_, r.data().native_handle(), static_cast<int>(r.size())) == 0;
+        return SDL_RenderFillRects(renderer_, r.data()->native_handle(), static_cast<int>(r.size())) == 0;
     else
-        return SDL_RenderFillRectsF(renderer_, r.data().native_handle(), static_cast<int>(r.size())) == 0;
+        return SDL_RenderFillRectsF(renderer_, r.data()->native_handle(), static_cast<int>(r.size())) == 0;
 }
 
 } // namespace sdl2
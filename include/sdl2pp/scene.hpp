@@ -0,0 +1,164 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "enums.hpp"
+#include "renderer.hpp"
+#include "shapes.hpp"
+#include "texture.hpp"
+#include "util.hpp"
+
+namespace sdl2 {
+
+/**
+ * @brief A retained sprite drawn by a scene.
+ */
+struct scene_node {
+    /**
+     * @brief The texture to draw. Must outlive the node.
+     */
+    texture const* txr = nullptr;
+
+    /**
+     * @brief The area of the texture to draw, or the whole texture if empty.
+     */
+    std::optional<rect<int>> src{};
+
+    /**
+     * @brief The destination area in world coordinates.
+     */
+    rect<int> dst{};
+
+    /**
+     * @brief Angle in degrees of the rotation (applied clockwise).
+     */
+    double angle = 0.0;
+
+    /**
+     * @brief The point relative to dst around which the node is rotated, or dst's center if empty.
+     */
+    std::optional<point<int>> center{};
+
+    /**
+     * @brief The flip actions to be performed on the texture.
+     */
+    renderer_flip flip = renderer_flip::NONE;
+
+    /**
+     * @brief The draw layer. Lower layers are drawn first.
+     */
+    int layer = 0;
+};
+
+/**
+ * @brief A retained set of sprites indexed by a uniform grid so that only visible nodes are drawn.
+ */
+class scene {
+public:
+    using node_id = std::uint32_t;
+
+private:
+    struct entry {
+        scene_node node;
+        rect<int> bounds;
+        std::uint64_t seq = 0;
+        mutable std::uint32_t stamp = 0;
+        bool alive = false;
+    };
+
+    std::vector<entry> entries_;
+    std::vector<node_id> free_;
+    std::unordered_map<std::uint64_t, std::vector<node_id>> cells_;
+    std::vector<node_id> visible_;
+    int cell_size_;
+    std::uint64_t next_seq_ = 0;
+    mutable std::uint32_t stamp_ = 0;
+
+    void link(node_id id);
+    void unlink(node_id id) noexcept;
+
+    template<class F>
+    void for_each_cell(rect<int> const& area, F&& f) const;
+
+public:
+    /**
+     * @brief Construct an empty scene.
+     * @param cell_size The width and height in world units of a grid cell.
+     */
+    explicit scene(int cell_size = 256);
+
+    /**
+     * @brief Add a node to the scene.
+     * @param node The node to add.
+     * @return The id used to refer to the node.
+     */
+    node_id add(scene_node const& node);
+
+    /**
+     * @brief Remove a node from the scene.
+     * @param id The node to remove.
+     */
+    void remove(node_id id);
+
+    /**
+     * @brief Replace a node, re-indexing it if its bounds changed.
+     * @param id The node to replace.
+     * @param node The new node data.
+     */
+    void update(node_id id, scene_node const& node);
+
+    /**
+     * @brief Move a node to a new destination area.
+     * @param id The node to move.
+     * @param dst The new destination area in world coordinates.
+     */
+    void move(node_id id, rect<int> const& dst);
+
+    /**
+     * @brief Access a node.
+     * @param id The node to access.
+     * @return The node.
+     */
+    scene_node const& node(node_id id) const noexcept;
+
+    /**
+     * @brief Checks if an id refers to a node in the scene.
+     * @param id The id to check.
+     * @return True if the node exists, false if not.
+     */
+    bool contains(node_id id) const noexcept;
+
+    /**
+     * @brief Get the number of nodes in the scene.
+     * @return The node count.
+     */
+    std::size_t size() const noexcept { return entries_.size() - free_.size(); }
+
+    /**
+     * @brief Remove all nodes.
+     */
+    void clear() noexcept;
+
+    /**
+     * @brief Find the nodes whose bounds intersect an area.
+     * @param area The area in world coordinates.
+     * @param out The vector to append the ids to, in layer order.
+     * @return The number of ids appended.
+     */
+    std::size_t query(rect<int> const& area, std::vector<node_id>& out) const;
+
+    /**
+     * @brief Draw the nodes visible in the renderer's viewport.
+     * @param r The renderer to draw with.
+     * @param camera The world position of the viewport's top left corner.
+     * @return True if succeeded, false if any copy failed.
+     */
+    bool draw(renderer& r, xy<int> camera = {});
+};
+
+} // namespace sdl2
@@ -1,14 +1,33 @@
 #pragma once
 
+#include "blur.hpp"
 #include "color.hpp"
+#include "dirty_region.hpp"
 #include "enums.hpp"
 #include "event.hpp"
+#include "frame_capture.hpp"
+#include "frame_sink.hpp"
+#include "glyph_cache.hpp"
+#include "histogram.hpp"
+#include "image_compare.hpp"
 #include "init.hpp"
 #include "message_box.hpp"
+#include "particles.hpp"
 #include "pixel.hpp"
+#include "qoi.hpp"
+#include "raster.hpp"
+#include "rect_batch.hpp"
 #include "renderer.hpp"
+#include "scene.hpp"
 #include "shapes.hpp"
+#include "soa.hpp"
+#include "span_sprite.hpp"
 #include "surface.hpp"
+#include "surface_pool.hpp"
+#include "surface_pyramid.hpp"
 #include "texture.hpp"
+#include "texture_pool.hpp"
+#include "tilemap.hpp"
+#include "transform.hpp"
 #include "util.h"
 #include "window.hpp"
\ No newline at end of file
@@ -2,7 +2,10 @@
 
 #include <SDL2/SDL.h>
 
+#include <algorithm>
 #include <concepts>
+#include <optional>
+#include <span>
 #include <type_traits>
 
 #include "util.hpp"
@@ -52,6 +55,51 @@ public:
         return {rect_.x + rect_.w / T{2}, rect_.y + rect_.h / T{2}};
     }
 
+    constexpr bool empty() const noexcept { return rect_.w <= T(0) || rect_.h <= T(0); }
+
+    constexpr bool contains(xy<T> const p) const noexcept {
+        return p.x >= rect_.x && p.x < rect_.x + rect_.w && p.y >= rect_.y && p.y < rect_.y + rect_.h;
+    }
+
+    constexpr bool contains(rect const& r) const noexcept {
+        return !r.empty() && r.rect_.x >= rect_.x && r.rect_.y >= rect_.y &&
+               r.rect_.x + r.rect_.w <= rect_.x + rect_.w && r.rect_.y + r.rect_.h <= rect_.y + rect_.h;
+    }
+
+    constexpr bool intersects(rect const& r) const noexcept {
+        return !empty() && !r.empty() &&
+               r.rect_.x < rect_.x + rect_.w && rect_.x < r.rect_.x + r.rect_.w &&
+               r.rect_.y < rect_.y + rect_.h && rect_.y < r.rect_.y + r.rect_.h;
+    }
+
+    constexpr std::optional<rect> intersection(rect const& r) const noexcept {
+        auto const x0 = std::max(rect_.x, r.rect_.x);
+        auto const y0 = std::max(rect_.y, r.rect_.y);
+        auto const x1 = std::min(rect_.x + rect_.w, r.rect_.x + r.rect_.w);
+        auto const y1 = std::min(rect_.y + rect_.h, r.rect_.y + r.rect_.h);
+        if (empty() || r.empty() || x1 <= x0 || y1 <= y0)
+            return {};
+        return rect{x0, y0, x1 - x0, y1 - y0};
+    }
+
+    constexpr rect united(rect const& r) const noexcept {
+        if (r.empty()) return *this;
+        if (empty()) return r;
+        auto const x0 = std::min(rect_.x, r.rect_.x);
+        auto const y0 = std::min(rect_.y, r.rect_.y);
+        auto const x1 = std::max(rect_.x + rect_.w, r.rect_.x + r.rect_.w);
+        auto const y1 = std::max(rect_.y + rect_.h, r.rect_.y + r.rect_.h);
+        return {x0, y0, x1 - x0, y1 - y0};
+    }
+
+    constexpr rect translated(xy<T> const d) const noexcept {
+        return {rect_.x + d.x, rect_.y + d.y, rect_.w, rect_.h};
+    }
+
+    friend constexpr bool operator==(rect const& a, rect const& b) noexcept {
+        return a.rect_.x == b.rect_.x && a.rect_.y == b.rect_.y && a.rect_.w == b.rect_.w && a.rect_.h == b.rect_.h;
+    }
+
     template<std::size_t I>
     constexpr auto& get() noexcept {
         if constexpr (I == 0) return x();
@@ -110,8 +158,50 @@ public:
         else if constexpr (I == 1) return y();
         else static_assert(always_false<T>::value, "invalid sdl2::point::get<I>() index");
     }
+
+    constexpr operator xy<T>() const noexcept { return {point_.x, point_.y}; }
 };
 
+namespace detail {
+
+template<sdl2_shape_rep T, class Pred>
+constexpr std::optional<rect<T>> _enclose_points_if(std::span<point<T> const> const points, Pred&& pred) noexcept {
+    bool found = false;
+    T x0{}, y0{}, x1{}, y1{};
+    for (auto const& p : points) {
+        if (!pred(p))
+            continue;
+        if (!found) {
+            x0 = x1 = p.x();
+            y0 = y1 = p.y();
+            found = true;
+            continue;
+        }
+        x0 = std::min(x0, p.x());
+        y0 = std::min(y0, p.y());
+        x1 = std::max(x1, p.x());
+        y1 = std::max(y1, p.y());
+    }
+    if (!found)
+        return {};
+    if constexpr (std::is_same_v<T, int>)
+        return rect<T>{x0, y0, x1 - x0 + 1, y1 - y0 + 1};
+    else
+        return rect<T>{x0, y0, x1 - x0, y1 - y0};
+}
+
+} // namespace detail
+
+template<sdl2_shape_rep T>
+constexpr std::optional<rect<T>> enclose_points(std::span<point<T> const> const points) noexcept {
+    return detail::_enclose_points_if(points, [](point<T> const&) { return true; });
+}
+
+template<sdl2_shape_rep T>
+constexpr std::optional<rect<T>> enclose_points(std::span<point<T> const> const points, rect<T> const& clip) noexcept {
+    return detail::_enclose_points_if(points, [&clip](point<T> const& p) { return clip.contains(p); });
+}
+
 } // namespace sdl2
 
 namespace std {
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "shapes.hpp"
+#include "util.hpp"
+
+namespace sdl2 {
+
+/**
+ * @brief A structure-of-arrays container of points.
+ * Coordinates are stored in separate x and y arrays so that transforms run as straight vector loops.
+ * @tparam T representation of values, either int or float.
+ */
+template<sdl2_shape_rep T>
+class soa_points {
+    std::vector<T> x_;
+    std::vector<T> y_;
+
+public:
+    soa_points() = default;
+
+    /**
+     * @brief Construct a container holding n points at the origin.
+     * @param n The number of points.
+     */
+    explicit soa_points(std::size_t n) : x_(n), y_(n) {}
+
+    /**
+     * @brief Construct a container from array-of-structs points.
+     * @param points The points to copy.
+     */
+    explicit soa_points(std::span<point<T> const> points) { unpack(points); }
+
+    std::size_t size() const noexcept { return x_.size(); }
+    bool empty() const noexcept { return x_.empty(); }
+    void reserve(std::size_t n) { x_.reserve(n); y_.reserve(n); }
+    void resize(std::size_t n) { x_.resize(n); y_.resize(n); }
+    void clear() noexcept { x_.clear(); y_.clear(); }
+
+    void push_back(point<T> const& p) { x_.push_back(p.x()); y_.push_back(p.y()); }
+
+    point<T> operator[](std::size_t i) const noexcept { return {x_[i], y_[i]}; }
+    void set(std::size_t i, point<T> const& p) noexcept { x_[i] = p.x(); y_[i] = p.y(); }
+
+    std::span<T> xs() noexcept { return x_; }
+    std::span<T> ys() noexcept { return y_; }
+    std::span<T const> xs() const noexcept { return x_; }
+    std::span<T const> ys() const noexcept { return y_; }
+
+    /**
+     * @brief Offset every point.
+     * @param d The offset to add.
+     */
+    void translate(xy<T> d) noexcept;
+
+    /**
+     * @brief Scale every point about an origin.
+     * @param factor The horizontal(x) and vertical(y) scaling factors.
+     * @param origin The fixed point of the scaling.
+     */
+    void scale(xy<float> factor, xy<T> origin = {}) noexcept;
+
+    /**
+     * @brief Rotate every point about an origin.
+     * @param degrees Angle in degrees of the rotation (applied clockwise in screen coordinates).
+     * @param origin The center of the rotation.
+     * @note Integer points are rounded to the nearest value.
+     */
+    void rotate(double degrees, xy<T> origin = {}) noexcept;
+
+    /**
+     * @brief Interleave the points into the array-of-structs layout used by the renderer.
+     * @param scratch A buffer reused between calls. It is resized to size().
+     * @return A span over scratch that can be passed to renderer::draw_points or renderer::draw_lines.
+     */
+    std::span<point<T> const> pack(std::vector<point<T>>& scratch) const;
+
+    /**
+     * @brief Replace the contents with array-of-structs points.
+     * @param points The points to copy.
+     */
+    void unpack(std::span<point<T> const> points);
+};
+
+/**
+ * @brief A structure-of-arrays container of rects.
+ * @tparam T representation of values, either int or float.
+ */
+template<sdl2_shape_rep T>
+class soa_rects {
+    std::vector<T> x_;
+    std::vector<T> y_;
+    std::vector<T> w_;
+    std::vector<T> h_;
+
+public:
+    soa_rects() = default;
+
+    /**
+     * @brief Construct a container holding n empty rects.
+     * @param n The number of rects.
+     */
+    explicit soa_rects(std::size_t n) : x_(n), y_(n), w_(n), h_(n) {}
+
+    /**
+     * @brief Construct a container from array-of-structs rects.
+     * @param rects The rects to copy.
+     */
+    explicit soa_rects(std::span<rect<T> const> rects) { unpack(rects); }
+
+    std::size_t size() const noexcept { return x_.size(); }
+    bool empty() const noexcept { return x_.empty(); }
+    void reserve(std::size_t n) { x_.reserve(n); y_.reserve(n); w_.reserve(n); h_.reserve(n); }
+    void resize(std::size_t n) { x_.resize(n); y_.resize(n); w_.resize(n); h_.resize(n); }
+    void clear() noexcept { x_.clear(); y_.clear(); w_.clear(); h_.clear(); }
+
+    void push_back(rect<T> const& r) { x_.push_back(r.x()); y_.push_back(r.y()); w_.push_back(r.w()); h_.push_back(r.h()); }
+
+    rect<T> operator[](std::size_t i) const noexcept { return {x_[i], y_[i], w_[i], h_[i]}; }
+    void set(std::size_t i, rect<T> const& r) noexcept { x_[i] = r.x(); y_[i] = r.y(); w_[i] = r.w(); h_[i] = r.h(); }
+
+    std::span<T> xs() noexcept { return x_; }
+    std::span<T> ys() noexcept { return y_; }
+    std::span<T> ws() noexcept { return w_; }
+    std::span<T> hs() noexcept { return h_; }
+    std::span<T const> xs() const noexcept { return x_; }
+    std::span<T const> ys() const noexcept { return y_; }
+    std::span<T const> ws() const noexcept { return w_; }
+    std::span<T const> hs() const noexcept { return h_; }
+
+    /**
+     * @brief Offset every rect.
+     * @param d The offset to add.
+     */
+    void translate(xy<T> d) noexcept;
+
+    /**
+     * @brief Scale the position and size of every rect about an origin.
+     * @param factor The horizontal(x) and vertical(y) scaling factors.
+     * @param origin The fixed point of the scaling.
+     */
+    void scale(xy<float> factor, xy<T> origin = {}) noexcept;
+
+    /**
+     * @brief Rotate the center of every rect about an origin, keeping the rects axis aligned.
+     * @param degrees Angle in degrees of the rotation (applied clockwise in screen coordinates).
+     * @param origin The center of the rotation.
+     */
+    void rotate(double degrees, xy<T> origin = {}) noexcept;
+
+    /**
+     * @brief Interleave the rects into the array-of-structs layout used by the renderer and surfaces.
+     * @param scratch A buffer reused between calls. It is resized to size().
+     * @return A span over scratch that can be passed to renderer::fill_rects or surface::fill_rects.
+     */
+    std::span<rect<T> const> pack(std::vector<rect<T>>& scratch) const;
+
+    /**
+     * @brief Replace the contents with array-of-structs rects.
+     * @param rects The rects to copy.
+     */
+    void unpack(std::span<rect<T> const> rects);
+};
+
+extern template class soa_points<int>;
+extern template class soa_points<float>;
+extern template class soa_rects<int>;
+extern template class soa_rects<float>;
+
+} // namespace sdl2
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "shapes.hpp"
+#include "util.hpp"
+
+namespace sdl2 {
+
+class surface;
+
+/**
+ * @brief A sprite stored as runs of visible pixels per row, so blitting skips transparent areas entirely.
+ * Each row holds opaque runs, which are copied straight into the destination, and translucent runs, which
+ * are alpha blended like SDL_BLENDMODE_BLEND. The encoding is built once from a surface with alpha or a
+ * color key, and can be serialized so that an asset pipeline does it ahead of time instead of at load time.
+ * Unlike SDL's RLE acceleration it does not depend on the destination format and survives conversions.
+ * @note Pixels are kept as straight-alpha ARGB8888.
+ */
+class span_sprite {
+    struct run {
+        std::uint32_t offset;
+        std::uint16_t x;
+        std::uint16_t length;
+        bool opaque;
+    };
+
+    wh<int> size_{0, 0};
+    std::vector<std::uint32_t> row_start_;
+    std::vector<run> runs_;
+    std::vector<std::uint32_t> pixels_;
+    bool valid_ = false;
+
+    bool parse(std::span<std::byte const> data);
+
+public:
+    /**
+     * @brief Construct an invalid sprite.
+     */
+    span_sprite() = default;
+
+    /**
+     * @brief Encode a surface. Pixels with alpha 0 or matching the color key are dropped, pixels with alpha 255 become opaque runs
+     * and the rest become translucent runs.
+     * @param src The surface to encode, at most 65535 pixels wide.
+     */
+    explicit span_sprite(surface const& src);
+
+    /**
+     * @brief Decode a sprite from the bytes made by serialize().
+     * @param data The serialized sprite.
+     */
+    explicit span_sprite(std::span<std::byte const> data);
+
+    /**
+     * @brief Load a sprite from a file written by save().
+     * @param file The path of the file.
+     */
+    explicit span_sprite(null_term_string file);
+
+    /**
+     * @brief Checks if the sprite was encoded or decoded successfully.
+     * @return True if valid, false if not.
+     */
+    explicit operator bool() const noexcept { return valid_; }
+
+    /**
+     * @brief Get the size of the encoded surface.
+     * @return The size in pixels.
+     */
+    wh<int> size() const noexcept { return size_; }
+
+    /**
+     * @brief Get the number of runs over all rows.
+     * @return The run count.
+     */
+    std::size_t run_count() const noexcept { return runs_.size(); }
+
+    /**
+     * @brief Get the number of visible pixels stored.
+     * @return The pixel count.
+     */
+    std::size_t pixel_count() const noexcept { return pixels_.size(); }
+
+    /**
+     * @brief Draw the sprite, clipped to the destination's clip rect.
+     * @param dst A surface with 8 bits per channel and 4 bytes per pixel, e.g. ARGB8888 or RGBA8888.
+     * @param at The position in dst of the sprite's top-left corner.
+     * @return True if succeeded, false if the sprite is invalid or dst has an unsupported format.
+     */
+    bool blit(surface& dst, point<int> at) const noexcept;
+
+    /**
+     * @brief Serialize the sprite into a portable little-endian byte stream.
+     * @return The bytes, or nothing if the sprite is invalid.
+     */
+    std::vector<std::byte> serialize() const;
+
+    /**
+     * @brief Serialize the sprite into a file.
+     * @param file The path of the file.
+     * @return True if succeeded, false if failed.
+     */
+    bool save(null_term_string file) const;
+};
+
+} // namespace sdl2
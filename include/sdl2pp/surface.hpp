@@ -3,7 +3,10 @@
 #include <SDL2/SDL.h>
 
 #include <atomic>
+#include <cstddef>
 #include <optional>
+#include <span>
+#include <utility>
 
 #include "pixel.hpp"
 #include "shapes.hpp"
@@ -11,11 +14,36 @@
 
 namespace sdl2 {
 
+/**
+ * @brief Alignment requirements for a surface that allocates its own pixels.
+ * Both values must be powers of two. A pitch alignment of 0 keeps rows packed (to SDL's 4 bytes).
+ */
+struct surface_alignment {
+    std::size_t pixels = 64;
+    std::size_t pitch = 64;
+};
+
+/**
+ * @brief One copy in a surface::blit_many batch.
+ */
+struct blit_op {
+    /**
+     * @brief The area of the source to copy.
+     */
+    rect<int> src{0, 0, 0, 0};
+
+    /**
+     * @brief The position in the destination of the area's top-left corner.
+     */
+    point<int> dst{0, 0};
+};
+
 /**
  * @brief 
  */ 
 class surface {
     SDL_Surface* surface_;
+    void* owned_pixels_ = nullptr;
 
 public:
     /**
@@ -82,11 +110,25 @@ public:
      */
     surface(void* pixels, int pitch, pixel_format_enum fmt, int depth, wh<int> wh) noexcept;
 
+    /**
+     * @brief Create a surface whose pixels start on a given alignment and whose rows are padded.
+     * The pixels are handed to SDL as a preallocated buffer (SDL_PREALLOC) and this object frees them
+     * once the last reference is dropped through it. Release references taken with refcount_add before
+     * destroying it, or the buffer is kept alive and leaks. Sub-byte and FOURCC formats are rejected.
+     * @param fmt The pixel format.
+     * @param wh The size in pixels.
+     * @param align The alignment of the first row and of the pitch. Aligning the pitch to a cache
+     *              line keeps threads working on different rows from sharing lines.
+     */
+    surface(pixel_format_enum fmt, wh<int> wh, surface_alignment align) noexcept;
+
     /**
      * @brief
      * @param file
+     * @param alpha PREMULTIPLIED converts the image to premultiplied alpha once at load time,
+     *              first converting to ARGB8888 if its alpha channel is not in a 32-bit format.
      */
-    explicit surface(null_term_string file) noexcept;
+    explicit surface(null_term_string file, alpha_format alpha = alpha_format::STRAIGHT) noexcept;
    
     /**
      * @brief The destructor. 
@@ -153,6 +195,12 @@ public:
      */
     constexpr int num_pixels() const noexcept;
 
+    /**
+     * @brief Get the alignment that the start of every row of pixels is guaranteed to have.
+     * @return The largest power of two, up to 4096, dividing both the pixels' address and the pitch.
+     */
+    std::size_t row_alignment() const noexcept;
+
     /**
      * @brief
      * @return
@@ -268,6 +316,100 @@ public:
      */
     bool blit(rect<int> const& srcrect, surface& dst) noexcept;
 
+    /**
+     * @brief Blit through the source's color key with a SIMD compare-and-select instead of SDL's generic blitter.
+     * The fast path needs both surfaces in the same 8, 16 or 32-bit format (and palette), a color key on the source,
+     * no alpha or color mod, and either blend mode NONE or a format without alpha. Other blits fall back to blit.
+     * @param srcrect
+     * @param dst
+     * @param dstrect Position in dst; on return holds the rect that was actually written.
+     * @return True if succeeded, false if failed.
+     */
+    bool blit_keyed(rect<int> const& srcrect, surface& dst, rect<int>& dstrect) noexcept;
+
+    /**
+     * @brief Blit through the source's color key with a SIMD compare-and-select.
+     * @param dst
+     * @param dstrect Position in dst; on return holds the rect that was actually written.
+     * @return True if succeeded, false if failed.
+     */
+    bool blit_keyed(surface& dst, rect<int>& dstrect) noexcept;
+
+    /**
+     * @brief Blit through the source's color key with a SIMD compare-and-select.
+     * @param dst
+     * @return True if succeeded, false if failed.
+     */
+    bool blit_keyed(surface& dst) noexcept;
+
+    /**
+     * @brief Blit through the source's color key with a SIMD compare-and-select.
+     * @param srcrect
+     * @param dst
+     * @return True if succeeded, false if failed.
+     */
+    bool blit_keyed(rect<int> const& srcrect, surface& dst) noexcept;
+
+    /**
+     * @brief Blit one area of the source through its color key to many positions, locking and checking formats once.
+     * @param srcrect The area of the source to copy, e.g. a sprite's frame.
+     * @param dst
+     * @param positions The top-left corner of each copy in dst. Later copies land on top of earlier ones.
+     * @return True if every copy succeeded, false if one failed.
+     */
+    bool blit_keyed(rect<int> const& srcrect, surface& dst, std::span<point<int> const> positions) noexcept;
+
+    /**
+     * @brief Run many blits from this surface to one destination, checking the formats and picking the copy loop once.
+     * Plain and color-keyed copies between identical formats run in place; any other combination falls back to blit per op.
+     * @param dst
+     * @param ops The areas to copy and where to put them. Later copies land on top of earlier ones.
+     * @param sort Run the copies top to bottom, left to right in dst for better cache locality. Overlapping copies may then stack differently.
+     * @return True if every copy succeeded, false if one failed.
+     */
+    bool blit_many(surface& dst, std::span<blit_op const> ops, bool sort = false) noexcept;
+
+    /**
+     * @brief Composite onto another surface with a Porter-Duff or separable blend operator.
+     * Clipping follows blit. The surfaces' blend mode, alpha mod and color mod are not applied.
+     * @param srcrect
+     * @param dst
+     * @param dstrect Position in dst; on return holds the rect that was actually written.
+     * @param op The compositing operator.
+     * @param alpha Whether both surfaces hold straight or premultiplied alpha.
+     * @return True if succeeded, false if either surface is not a 32-bit format with 8-bit channels.
+     */
+    bool composite(rect<int> const& srcrect, surface& dst, rect<int>& dstrect, composite_op op, alpha_format alpha = alpha_format::STRAIGHT) noexcept;
+
+    /**
+     * @brief Composite onto another surface with a Porter-Duff or separable blend operator.
+     * @param dst
+     * @param dstrect Position in dst; on return holds the rect that was actually written.
+     * @param op The compositing operator.
+     * @param alpha Whether both surfaces hold straight or premultiplied alpha.
+     * @return True if succeeded, false if either surface is not a 32-bit format with 8-bit channels.
+     */
+    bool composite(surface& dst, rect<int>& dstrect, composite_op op, alpha_format alpha = alpha_format::STRAIGHT) noexcept;
+
+    /**
+     * @brief Composite onto another surface with a Porter-Duff or separable blend operator.
+     * @param dst
+     * @param op The compositing operator.
+     * @param alpha Whether both surfaces hold straight or premultiplied alpha.
+     * @return True if succeeded, false if either surface is not a 32-bit format with 8-bit channels.
+     */
+    bool composite(surface& dst, composite_op op, alpha_format alpha = alpha_format::STRAIGHT) noexcept;
+
+    /**
+     * @brief Composite onto another surface with a Porter-Duff or separable blend operator.
+     * @param srcrect
+     * @param dst
+     * @param op The compositing operator.
+     * @param alpha Whether both surfaces hold straight or premultiplied alpha.
+     * @return True if succeeded, false if either surface is not a 32-bit format with 8-bit channels.
+     */
+    bool composite(rect<int> const& srcrect, surface& dst, composite_op op, alpha_format alpha = alpha_format::STRAIGHT) noexcept;
+
     /**
      * @brief
      * @param srcrect
@@ -401,6 +543,20 @@ public:
      */
     surface convert_to_new(sdl2::pixel_format const& fmt) const noexcept;
 
+    /**
+     * @brief Multiply the color channels of every pixel by its alpha, in place.
+     * @return True if succeeded or the format has no alpha, false if the alpha channel is not
+     *         part of a 32-bit format with 8-bit channels.
+     */
+    bool premultiply_alpha() noexcept;
+
+    /**
+     * @brief Divide the color channels of every pixel by its alpha, in place. Fully transparent pixels become black.
+     * @return True if succeeded or the format has no alpha, false if the alpha channel is not
+     *         part of a 32-bit format with 8-bit channels.
+     */
+    bool unpremultiply_alpha() noexcept;
+
     /**
      * @brief
      * @return 
@@ -496,4 +652,34 @@ public:
  */
 bool convert_pixels(wh<int> wh, surface const& src, surface& dst) noexcept;
 
+// sdl2::surface constexpr method implementations
+constexpr surface::surface(surface&& other) noexcept 
+    : surface_(std::exchange(other.surface_, nullptr)), owned_pixels_(std::exchange(other.owned_pixels_, nullptr))
+{}
+
+constexpr const_pixel_format_view surface::pixel_format() const noexcept { 
+    SDL2_ASSERT(surface_->format != nullptr);
+    return {surface_->format}; 
+}
+
+constexpr int surface::width() const noexcept { return surface_->w; }
+constexpr int surface::height() const noexcept { return surface_->h; }
+constexpr int surface::pitch() const noexcept { return surface_->pitch; }
+constexpr void const* surface::pixels() const noexcept { return surface_->pixels; }
+constexpr void* surface::pixels() noexcept { return surface_->pixels; }
+constexpr int surface::num_pixels() const noexcept { return height() * pitch(); }
+constexpr void const* surface::userdata() const noexcept { return surface_->userdata; }
+constexpr void* surface::userdata() noexcept { return surface_->userdata; }
+constexpr void surface::set_userdata(void* const userdata) noexcept { surface_->userdata = userdata; }
+constexpr rect<int> surface::clip_rect() const noexcept { return surface_->clip_rect; }
+constexpr int surface::refcount() const noexcept { return surface_->refcount; }
+constexpr int surface::refcount_add(int const amt) noexcept { 
+    surface_->refcount += amt; 
+    return surface_->refcount; 
+}
+constexpr int surface::refcount_sub(int const amt) noexcept { 
+    surface_->refcount -= amt; 
+    return surface_->refcount; 
+}
+
 } // namespace sdl2
\ No newline at end of file
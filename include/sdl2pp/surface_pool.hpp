@@ -0,0 +1,153 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "enums.hpp"
+#include "surface.hpp"
+#include "util.hpp"
+
+namespace sdl2 {
+
+class surface_pool;
+
+/**
+ * @brief A surface whose pixel buffer is borrowed from a surface_pool and returned to it on destruction.
+ */
+class pooled_surface {
+    surface_pool* pool_;
+    std::byte* buffer_;
+    std::uint64_t key_;
+    surface surface_;
+
+    friend class surface_pool;
+
+    pooled_surface(surface_pool* pool, std::byte* buffer, std::uint64_t key, surface&& s) noexcept
+        : pool_{pool}, buffer_{buffer}, key_{key}, surface_{std::move(s)} {}
+
+public:
+    /**
+     * @brief Copy constructor deleted.
+     */
+    pooled_surface(pooled_surface const&) = delete;
+
+    /**
+     * @brief Copy assignment deleted.
+     */
+    pooled_surface& operator=(pooled_surface const&) = delete;
+
+    /**
+     * @brief Move assignment deleted.
+     */
+    pooled_surface& operator=(pooled_surface&&) = delete;
+
+    /**
+     * @brief Move constructor.
+     * @param other The pooled surface to move into this one.
+     */
+    pooled_surface(pooled_surface&& other) noexcept
+        : pool_{std::exchange(other.pool_, nullptr)}
+        , buffer_{std::exchange(other.buffer_, nullptr)}
+        , key_{other.key_}
+        , surface_{std::move(other.surface_)}
+    {}
+
+    /**
+     * @brief The destructor. Frees the surface and hands its pixel buffer back to the pool.
+     */
+    ~pooled_surface() noexcept;
+
+    /**
+     * @brief Checks if the surface is in a valid state.
+     * @return True if valid, false if not.
+     */
+    explicit operator bool() const noexcept { return static_cast<bool>(surface_); }
+
+    surface& get() noexcept { return surface_; }
+    surface const& get() const noexcept { return surface_; }
+    surface& operator*() noexcept { return surface_; }
+    surface const& operator*() const noexcept { return surface_; }
+    surface* operator->() noexcept { return &surface_; }
+    surface const* operator->() const noexcept { return &surface_; }
+};
+
+/**
+ * @brief Recycles the pixel buffers of short-lived scratch surfaces.
+ * Buffers are kept per pixel format and power-of-two size class, so once the pool has warmed up
+ * acquiring a surface reuses memory instead of allocating pixels. SDL still allocates the small
+ * SDL_Surface header for each surface.
+ * @note Not thread safe. The pool must outlive every surface acquired from it.
+ */
+class surface_pool {
+    struct bucket {
+        std::vector<std::byte*> idle;
+        std::size_t allocated = 0;
+    };
+
+    std::unordered_map<std::uint64_t, bucket> buckets_;
+    std::size_t idle_bytes_ = 0;
+    std::size_t outstanding_ = 0;
+    std::size_t max_idle_bytes_;
+
+    friend class pooled_surface;
+
+    std::byte* take(std::uint64_t key);
+    void release(std::byte* buffer, std::uint64_t key) noexcept;
+
+public:
+    /**
+     * @brief Construct an empty pool.
+     * @param max_idle_bytes The most memory to keep cached; buffers returned beyond it are freed.
+     */
+    explicit surface_pool(std::size_t max_idle_bytes = 64 * 1024 * 1024) noexcept
+        : max_idle_bytes_{max_idle_bytes} {}
+
+    surface_pool(surface_pool const&) = delete;
+    surface_pool& operator=(surface_pool const&) = delete;
+
+    /**
+     * @brief The destructor. Frees every cached buffer.
+     */
+    ~surface_pool() noexcept;
+
+    /**
+     * @brief Get a surface backed by a pooled pixel buffer.
+     * @param fmt The pixel format. FOURCC formats are not supported.
+     * @param size The size of the surface in pixels.
+     * @return The surface, which is invalid if the format is unsupported or SDL failed to create it.
+     * @note The pixel contents are left as the previous user left them.
+     */
+    pooled_surface acquire(pixel_format_enum fmt, wh<int> size);
+
+    /**
+     * @brief Reserve cached buffers ahead of time so the first frames do not allocate either.
+     * @param fmt The pixel format.
+     * @param size The size of the surfaces in pixels.
+     * @param count The number of buffers to keep ready.
+     */
+    void reserve(pixel_format_enum fmt, wh<int> size, std::size_t count);
+
+    /**
+     * @brief Free every cached buffer that is not in use.
+     */
+    void trim() noexcept;
+
+    /**
+     * @brief Get the number of bytes held in cached buffers.
+     * @return The idle byte count.
+     */
+    std::size_t idle_bytes() const noexcept { return idle_bytes_; }
+
+    /**
+     * @brief Get the number of acquired surfaces that have not yet been returned.
+     * @return The outstanding surface count.
+     */
+    std::size_t outstanding() const noexcept { return outstanding_; }
+};
+
+} // namespace sdl2
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include <cstddef>
+#include <vector>
+
+#include "enums.hpp"
+#include "shapes.hpp"
+#include "surface.hpp"
+#include "texture.hpp"
+#include "util.hpp"
+
+namespace sdl2 {
+
+class renderer;
+
+/**
+ * @brief A mip chain: a surface followed by successively halved copies of it, down to 1x1.
+ * Drawing a level close to the destination size instead of minifying the full image avoids aliasing
+ * and reads far fewer pixels. Levels are built with SSE2 (box) or vectorised (Kaiser) loops, split
+ * across threads for large images.
+ * @note Channels are filtered as stored. Premultiply straight-alpha images with transparent areas first,
+ *       or colors of fully transparent pixels bleed into their neighbours.
+ */
+class surface_pyramid {
+    std::vector<surface> levels_;
+
+public:
+    /**
+     * @brief Construct an empty pyramid.
+     */
+    surface_pyramid() = default;
+
+    /**
+     * @brief Build the chain for a surface.
+     * @param base The full-resolution image. Formats without 8-bit channels in 4 bytes are converted to ARGB8888.
+     * @param filter The downsampling filter.
+     * @param max_levels The most levels to keep, counting the base, or 0 to go down to 1x1.
+     * @param threads The number of threads to filter large levels with.
+     */
+    explicit surface_pyramid(surface const& base, mip_filter filter = mip_filter::BOX, std::size_t max_levels = 0, std::size_t threads = 1);
+
+    surface_pyramid(surface_pyramid&&) noexcept = default;
+    surface_pyramid& operator=(surface_pyramid&&) noexcept = default;
+
+    /**
+     * @brief Checks if every level was built.
+     * @return True if valid, false if not.
+     */
+    explicit operator bool() const noexcept { return !levels_.empty(); }
+
+    /**
+     * @brief Get the number of levels, counting the base.
+     * @return The level count.
+     */
+    std::size_t size() const noexcept { return levels_.size(); }
+
+    /**
+     * @brief Get a level.
+     * @param level The level, 0 being the base.
+     * @return The surface.
+     */
+    surface& operator[](std::size_t level) noexcept { return levels_[level]; }
+    surface const& operator[](std::size_t level) const noexcept { return levels_[level]; }
+
+    /**
+     * @brief Pick the smallest level that still has at least as many pixels as the destination in both directions.
+     * @param dst_size The size the whole image is drawn at.
+     * @return The level.
+     */
+    std::size_t level_for(wh<int> dst_size) const noexcept;
+
+    /**
+     * @brief Pick the smallest level that still has at least as many pixels as the destination in both directions.
+     * @param srcrect The area of the base drawn.
+     * @param dstrect Where it is drawn.
+     * @return The level.
+     */
+    std::size_t level_for(rect<int> const& srcrect, rect<int> const& dstrect) const noexcept;
+
+    /**
+     * @brief Map an area of the base to the same area of a level.
+     * @param srcrect The area in base pixels.
+     * @param level The level.
+     * @return The area in the level's pixels, rounded outwards.
+     */
+    rect<int> level_rect(rect<int> const& srcrect, std::size_t level) const noexcept;
+
+    /**
+     * @brief Upload every level to its own texture.
+     * @param r The rendering context.
+     * @param alpha The alpha format of the levels' pixels. PREMULTIPLIED sets premultiplied_blend_mode().
+     * @return A texture per level, in order. Check each for validity.
+     */
+    std::vector<texture> make_textures(renderer& r, alpha_format alpha = alpha_format::STRAIGHT) const;
+};
+
+} // namespace sdl2
@@ -58,6 +58,14 @@ public:
     }
 };
 
+/**
+ * @brief Get the blend mode for drawing textures whose pixels hold premultiplied alpha.
+ * It is composed with SDL_ComposeCustomBlendMode as src + dst * (1 - src.alpha) for both color and alpha.
+ * @return The custom blend mode. Renderers that cannot express it reject it in texture::set_blend_mode.
+ * @note Alpha mod only scales alpha, so with premultiplied textures set an equal color mod along with it.
+ */
+sdl2::blend_mode premultiplied_blend_mode() noexcept;
+
 /**
  * @brief A wrapper around an SDL_Texture structure.
  */ 
@@ -88,14 +96,23 @@ public:
      */
     texture(renderer& r, surface const& s) noexcept;
 
+    /**
+     * @brief Creates a texture from an existing surface, selecting the blend mode for its alpha format.
+     * @param r The rendering context.
+     * @param s The surface containing pixel data used to fill the texture.
+     * @param alpha The alpha format the surface's pixels are already in. PREMULTIPLIED sets premultiplied_blend_mode().
+     */
+    texture(renderer& r, surface const& s, alpha_format alpha) noexcept;
+
     /**
      * @brief Create a texture from a file using SDL_Image API.
      * @param r The rendering context.
      * @param file The path to the file to load the texture from.
+     * @param alpha PREMULTIPLIED converts the pixels to premultiplied alpha once at load time and sets premultiplied_blend_mode().
      * @note The IMG library must have been initialized for this to work
      * @note This creates a temporary surface to use to create the texture.
      */
-    texture(renderer& r, null_term_string file) noexcept;
+    texture(renderer& r, null_term_string file, alpha_format alpha = alpha_format::STRAIGHT) noexcept;
 
     /**
      * @brief Copy constructor deleted.
@@ -282,6 +299,77 @@ public:
                     std::span<std::byte const> uplane, int upitch,
                     std::span<std::byte const> vplane, int vpitch) noexcept;
 
+    /**
+     * @brief Updates a rectangle within a biplanar NV12 or NV21 texture with new pixel data.
+     * @param rect The area to update.
+     * @param yplane Span of raw pixel data for the Y plane.
+     * @param ypitch Number of bytes between rows of pixel data for the Y plane.
+     * @param uvplane Span of raw pixel data for the interleaved UV (NV12) or VU (NV21) plane.
+     * @param uvpitch Number of bytes between rows of pixel data for the UV plane.
+     * @return True if succeeded, false if failed.
+     */
+    bool update_nv(rect<int> const& rect,
+                   std::span<std::byte const> yplane, int ypitch,
+                   std::span<std::byte const> uvplane, int uvpitch) noexcept;
+
+    /**
+     * @brief Updates the entire biplanar NV12 or NV21 texture with new pixel data.
+     * @param yplane Span of raw pixel data for the Y plane.
+     * @param ypitch Number of bytes between rows of pixel data for the Y plane.
+     * @param uvplane Span of raw pixel data for the interleaved UV (NV12) or VU (NV21) plane.
+     * @param uvpitch Number of bytes between rows of pixel data for the UV plane.
+     * @return True if succeeded, false if failed.
+     */
+    bool update_nv(std::span<std::byte const> yplane, int ypitch,
+                   std::span<std::byte const> uvplane, int uvpitch) noexcept;
+
 };  
 
+/**
+ * @brief Split an interleaved chroma plane (NV12's UV or NV21's VU) into two planar ones.
+ * Use it to feed NV12/NV21 frames to an IYUV/YV12 texture on renderers without biplanar textures.
+ * @param size The size of the chroma plane in sample pairs.
+ * @param uv The interleaved plane.
+ * @param uvpitch Number of bytes between rows of the interleaved plane.
+ * @param first The plane receiving the first sample of each pair (U for NV12, V for NV21).
+ * @param first_pitch Number of bytes between rows of first.
+ * @param second The plane receiving the second sample of each pair.
+ * @param second_pitch Number of bytes between rows of second.
+ * @return True if succeeded, false if a plane is too small.
+ */
+bool split_uv(wh<int> size,
+              std::span<std::byte const> uv, int uvpitch,
+              std::span<std::byte> first, int first_pitch,
+              std::span<std::byte> second, int second_pitch) noexcept;
+
+/**
+ * @brief Interleave two planar chroma planes into one, the inverse of split_uv.
+ * @param size The size of each chroma plane in samples.
+ * @param first The plane whose samples come first in each pair (U for NV12, V for NV21).
+ * @param first_pitch Number of bytes between rows of first.
+ * @param second The plane whose samples come second in each pair.
+ * @param second_pitch Number of bytes between rows of second.
+ * @param uv The interleaved plane.
+ * @param uvpitch Number of bytes between rows of the interleaved plane.
+ * @return True if succeeded, false if a plane is too small.
+ */
+bool merge_uv(wh<int> size,
+              std::span<std::byte const> first, int first_pitch,
+              std::span<std::byte const> second, int second_pitch,
+              std::span<std::byte> uv, int uvpitch) noexcept;
+
+/**
+ * @brief Narrow a plane of 16-bit samples holding 10 significant high bits (P010, P016) to 8 bits.
+ * Apply it to the Y plane and to the UV plane (with twice the chroma width) to get NV12 for update_nv.
+ * @param size The size of the plane in samples.
+ * @param src The 16-bit plane in native byte order.
+ * @param src_pitch Number of bytes between rows of src.
+ * @param dst The 8-bit plane.
+ * @param dst_pitch Number of bytes between rows of dst.
+ * @return True if succeeded, false if a plane is too small.
+ */
+bool narrow_p010(wh<int> size,
+                 std::span<std::byte const> src, int src_pitch,
+                 std::span<std::byte> dst, int dst_pitch) noexcept;
+
 } // namespace sdl2
\ No newline at end of file
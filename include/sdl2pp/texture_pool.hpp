@@ -0,0 +1,185 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "enums.hpp"
+#include "shapes.hpp"
+#include "texture.hpp"
+#include "util.hpp"
+
+namespace sdl2 {
+
+class renderer;
+class texture_pool;
+
+/**
+ * @brief A texture leased from a texture_pool and returned to it on destruction.
+ * The texture may be larger than requested when the pool buckets sizes; draw from src_rect().
+ */
+class pooled_texture {
+    texture_pool* pool_;
+    std::uint64_t key_;
+    wh<int> size_;
+    texture texture_;
+
+    friend class texture_pool;
+
+    pooled_texture(texture_pool* pool, std::uint64_t key, wh<int> size, texture&& t) noexcept
+        : pool_{pool}, key_{key}, size_{size}, texture_{std::move(t)} {}
+
+public:
+    /**
+     * @brief Copy constructor deleted.
+     */
+    pooled_texture(pooled_texture const&) = delete;
+
+    /**
+     * @brief Copy assignment deleted.
+     */
+    pooled_texture& operator=(pooled_texture const&) = delete;
+
+    /**
+     * @brief Move assignment deleted.
+     */
+    pooled_texture& operator=(pooled_texture&&) = delete;
+
+    /**
+     * @brief Move constructor.
+     * @param other The pooled texture to move into this one.
+     */
+    pooled_texture(pooled_texture&& other) noexcept
+        : pool_{std::exchange(other.pool_, nullptr)}
+        , key_{other.key_}
+        , size_{other.size_}
+        , texture_{std::move(other.texture_)}
+    {}
+
+    /**
+     * @brief The destructor. Hands the texture back to the pool.
+     */
+    ~pooled_texture() noexcept;
+
+    /**
+     * @brief Checks if the texture is in a valid state.
+     * @return True if valid, false if not.
+     */
+    explicit operator bool() const noexcept { return static_cast<bool>(texture_); }
+
+    /**
+     * @brief Get the size that was requested, which may be smaller than the texture.
+     * @return The requested size.
+     */
+    wh<int> size() const noexcept { return size_; }
+
+    /**
+     * @brief Get the area of the texture that corresponds to the requested size.
+     * @return The rect at the origin with the requested size.
+     */
+    rect<int> src_rect() const noexcept { return {0, 0, size_.width, size_.height}; }
+
+    texture& get() noexcept { return texture_; }
+    texture const& get() const noexcept { return texture_; }
+    texture& operator*() noexcept { return texture_; }
+    texture const& operator*() const noexcept { return texture_; }
+    texture* operator->() noexcept { return &texture_; }
+    texture const* operator->() const noexcept { return &texture_; }
+};
+
+/**
+ * @brief Recycles textures by format, access and size so steady-state frames create none.
+ * Leased textures come back with their blend mode, alpha mod and color mod reset to what SDL gives a new texture
+ * of their format. Their scale mode is left as the previous lease set it.
+ * @note Not thread safe. The pool must outlive every texture leased from it and must be destroyed before its renderer.
+ */
+class texture_pool {
+public:
+    /**
+     * @brief Counters for verifying that the pool has reached a steady state.
+     * created counts SDL_CreateTexture calls, so an unchanged value across a frame means the frame
+     * made no driver allocations. Byte counts are estimates from the format and size.
+     */
+    struct statistics {
+        std::size_t created = 0;
+        std::size_t destroyed = 0;
+        std::size_t hits = 0;
+        std::size_t misses = 0;
+        std::size_t live_bytes = 0;
+        std::size_t idle_bytes = 0;
+    };
+
+private:
+    struct bucket {
+        std::vector<texture> idle;
+        std::size_t allocated = 0;
+        std::uint64_t last_used = 0;
+    };
+
+    renderer& renderer_;
+    std::unordered_map<std::uint64_t, bucket> buckets_;
+    std::size_t max_bytes_;
+    bool bucket_sizes_;
+    std::uint64_t clock_ = 0;
+    statistics stats_;
+
+    friend class pooled_texture;
+
+    void release(texture&& t, std::uint64_t key) noexcept;
+    void evict_for(std::size_t bytes) noexcept;
+
+public:
+    /**
+     * @brief Construct an empty pool.
+     * @param r The renderer textures are created for.
+     * @param max_bytes Estimated texture memory, leased and idle, above which idle textures are destroyed.
+     *                  If every texture is leased the cap is exceeded rather than failing.
+     * @param bucket_sizes Round sizes up (to within 25% per dimension) so nearby sizes share textures.
+     */
+    explicit texture_pool(renderer& r, std::size_t max_bytes = 256 * 1024 * 1024, bool bucket_sizes = true) noexcept
+        : renderer_{r}, max_bytes_{max_bytes}, bucket_sizes_{bucket_sizes} {}
+
+    texture_pool(texture_pool const&) = delete;
+    texture_pool& operator=(texture_pool const&) = delete;
+
+    /**
+     * @brief The destructor. Destroys every idle texture.
+     */
+    ~texture_pool() noexcept;
+
+    /**
+     * @brief Lease a texture, reusing an idle one of the same format, access and size bucket if possible.
+     * @param format The pixel format.
+     * @param access The texture access.
+     * @param size The required size in pixels.
+     * @return The leased texture, which is invalid if SDL failed to create it.
+     * @note Pixel contents of reused textures are undefined.
+     */
+    pooled_texture acquire(pixel_format_enum format, texture_access access, wh<int> size);
+
+    /**
+     * @brief Create idle textures ahead of time so the first frames do not create any.
+     * @param format The pixel format.
+     * @param access The texture access.
+     * @param size The size in pixels.
+     * @param count The number of textures to keep ready.
+     */
+    void reserve(pixel_format_enum format, texture_access access, wh<int> size, std::size_t count);
+
+    /**
+     * @brief Destroy every idle texture.
+     */
+    void trim() noexcept;
+
+    /**
+     * @brief Get the pool's counters.
+     * @return The counters since construction.
+     */
+    statistics const& stats() const noexcept { return stats_; }
+};
+
+} // namespace sdl2
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "shapes.hpp"
+#include "texture.hpp"
+#include "util.hpp"
+
+namespace sdl2 {
+
+class renderer;
+
+/**
+ * @brief A grid of tiles drawn from a tileset, cached per chunk in render target textures.
+ * Each chunk is rendered tile by tile into its own TARGET texture the first time it is visible and
+ * again only after one of its tiles changes, so a frame costs one copy per visible chunk. Chunk
+ * textures are created lazily, and beyond a budget the least recently drawn chunk's texture is
+ * reused for the next chunk that needs one.
+ * @note Not thread safe. The tileset must outlive the map, and the map must be destroyed before its renderer.
+ *       Call invalidate() when SDL reports SDL_RENDER_TARGETS_RESET, since the chunk textures lose their contents.
+ */
+class tilemap {
+public:
+    /**
+     * @brief The index of a tile in the tileset, counting left to right, top to bottom.
+     */
+    using tile_id = std::uint16_t;
+
+    /**
+     * @brief The id of a cell with no tile, drawn transparent.
+     */
+    static constexpr tile_id no_tile = 0xFFFF;
+
+    /**
+     * @brief Counters for the most recent draw call.
+     */
+    struct statistics {
+        std::size_t chunks_drawn = 0;
+        std::size_t chunks_rendered = 0;
+        std::size_t tiles_rendered = 0;
+        std::size_t cached_chunks = 0;
+    };
+
+private:
+    struct chunk {
+        std::optional<texture> txr;
+        std::uint64_t last_drawn = 0;
+        bool dirty = true;
+    };
+
+    renderer& renderer_;
+    texture& tileset_;
+    wh<int> tile_size_;
+    wh<int> map_size_;
+    int chunk_tiles_;
+    wh<int> chunks_size_;
+    int tileset_columns_;
+    std::size_t max_cached_chunks_;
+    std::vector<tile_id> tiles_;
+    std::vector<chunk> chunks_;
+    std::vector<std::size_t> cached_;
+    std::uint64_t frame_ = 0;
+    statistics stats_;
+
+    bool acquire_texture(std::size_t index) noexcept;
+    bool render_chunk(std::size_t index) noexcept;
+
+public:
+    /**
+     * @brief Construct a map with every cell empty.
+     * @param r The renderer the map is drawn with.
+     * @param tileset The texture holding the tiles in a grid with no spacing. Chunks are drawn with its blend mode,
+     *                which is switched to NONE while tiles are rendered into them and restored after.
+     * @param tile_size The size of one tile in pixels.
+     * @param map_size The size of the map in tiles.
+     * @param chunk_tiles The width and height of a chunk in tiles.
+     * @param max_cached_chunks The number of chunk textures to keep before reusing old ones.
+     *                          More are created while every cached chunk is visible.
+     */
+    tilemap(renderer& r, texture& tileset, wh<int> tile_size, wh<int> map_size, int chunk_tiles = 32, std::size_t max_cached_chunks = 64);
+
+    tilemap(tilemap const&) = delete;
+    tilemap& operator=(tilemap const&) = delete;
+
+    /**
+     * @brief Get the size of the map.
+     * @return The size in tiles.
+     */
+    wh<int> size() const noexcept { return map_size_; }
+
+    /**
+     * @brief Get the size of a tile.
+     * @return The size in pixels.
+     */
+    wh<int> tile_size() const noexcept { return tile_size_; }
+
+    /**
+     * @brief Get a tile.
+     * @param cell The cell, which must be inside the map.
+     * @return The tile id, or no_tile.
+     */
+    tile_id tile(point<int> cell) const noexcept;
+
+    /**
+     * @brief Set a tile, marking its chunk for re-rendering if it changed.
+     * @param cell The cell. Cells outside the map are ignored.
+     * @param id The tile id, or no_tile.
+     */
+    void set_tile(point<int> cell, tile_id id) noexcept;
+
+    /**
+     * @brief Set every tile in a rectangle.
+     * @param area The cells to set, clipped to the map.
+     * @param id The tile id, or no_tile.
+     */
+    void fill(rect<int> const& area, tile_id id) noexcept;
+
+    /**
+     * @brief Mark every chunk for re-rendering.
+     */
+    void invalidate() noexcept;
+
+    /**
+     * @brief Draw the part of the map visible in the renderer's viewport.
+     * @param camera The map pixel drawn at the viewport's top-left corner.
+     * @return True if succeeded, false if a chunk could not be rendered or copied.
+     */
+    bool draw(point<int> camera) noexcept;
+
+    /**
+     * @brief Get the counters for the most recent draw.
+     * @return The counters.
+     */
+    statistics const& stats() const noexcept { return stats_; }
+};
+
+} // namespace sdl2
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include <cstddef>
+
+#include "enums.hpp"
+#include "surface.hpp"
+
+namespace sdl2 {
+
+/**
+ * @brief Mirror a surface in place.
+ * Rows are reversed with SSE2 shuffles for 8, 16 and 32-bit pixels; 24-bit pixels are swapped one at a time.
+ * @param s The surface, with 8, 16, 24 or 32-bit pixels.
+ * @param direction HORIZONTAL, VERTICAL or both (HORIZONTAL | VERTICAL, the same as a half turn).
+ * @return True if succeeded, false if the surface or format is unsupported.
+ */
+bool flip(surface& s, renderer_flip direction) noexcept;
+
+/**
+ * @brief Make a mirrored copy of a surface, with its palette, color key, blend mode and modulation.
+ * @param s The surface, with 8, 16, 24 or 32-bit pixels.
+ * @param direction HORIZONTAL, VERTICAL or both.
+ * @return The copy, invalid if failed.
+ */
+surface flipped(surface const& s, renderer_flip direction) noexcept;
+
+/**
+ * @brief Swap the rows and columns of a square surface in place.
+ * Tiles mirrored across the diagonal are loaded, transposed in registers and stored in each other's place.
+ * @param s The surface, which must be square, with 8, 16, 24 or 32-bit pixels.
+ * @param threads The number of threads to split the tile rows across.
+ * @return True if succeeded, false if the surface is not square or the format is unsupported.
+ */
+bool transpose(surface& s, std::size_t threads = 1);
+
+/**
+ * @brief Make a copy of a surface with its rows and columns swapped.
+ * The copy is done in 64x64-pixel blocks, so both surfaces are walked a few cache lines at a time, and each
+ * block in 4x4 (32-bit) or 8x8 (8 and 16-bit) tiles transposed in SSE2 registers.
+ * @param s The surface, with 8, 16, 24 or 32-bit pixels.
+ * @param threads The number of threads to split the blocks across.
+ * @return The copy, invalid if failed.
+ */
+surface transposed(surface const& s, std::size_t threads = 1);
+
+/**
+ * @brief Rotate a surface in place. Quarter turns need a square surface.
+ * @param s The surface, with 8, 16, 24 or 32-bit pixels.
+ * @param r The rotation.
+ * @param threads The number of threads to transpose with.
+ * @return True if succeeded, false if a quarter turn was asked of a surface that is not square, or the format is unsupported.
+ */
+bool rotate(surface& s, rotation r, std::size_t threads = 1);
+
+/**
+ * @brief Make a rotated copy of a surface. Quarter turns are blocked transposes reading the rows or writing
+ * the columns in reverse, so they cost no more than transposed().
+ * @param s The surface, with 8, 16, 24 or 32-bit pixels.
+ * @param r The rotation.
+ * @param threads The number of threads to use.
+ * @return The copy, invalid if failed.
+ */
+surface rotated(surface const& s, rotation r, std::size_t threads = 1);
+
+} // namespace sdl2
@@ -0,0 +1,227 @@
+#include "sdl2pp/surface.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "pixel_access.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SDL2PP_BLIT_SSE2 1
+#endif
+
+using namespace sdl2;
+
+namespace {
+
+using row_fn = void (*)(std::uint8_t const*, std::uint8_t*, int, std::uint32_t, std::uint32_t) noexcept;
+
+// copies the n pixels of s whose color bits, s & mask, differ from key into d
+template<int Bytes>
+void keyed_row(std::uint8_t const* const s, std::uint8_t* const d, int const n, std::uint32_t const key, std::uint32_t const mask) noexcept {
+    int x = 0;
+#ifdef SDL2PP_BLIT_SSE2
+    constexpr int step = 16 / Bytes;
+    auto const cmp = [](__m128i const a, __m128i const b) {
+        if constexpr (Bytes == 1) return _mm_cmpeq_epi8(a, b);
+        else if constexpr (Bytes == 2) return _mm_cmpeq_epi16(a, b);
+        else return _mm_cmpeq_epi32(a, b);
+    };
+    auto const splat = [](std::uint32_t const v) {
+        if constexpr (Bytes == 1) return _mm_set1_epi8(static_cast<char>(v));
+        else if constexpr (Bytes == 2) return _mm_set1_epi16(static_cast<short>(v));
+        else return _mm_set1_epi32(static_cast<int>(v));
+    };
+    auto const k = splat(key), m = splat(mask);
+    for (; x + step <= n; x += step) {
+        auto const sv = _mm_loadu_si128(reinterpret_cast<__m128i const*>(s + x * Bytes));
+        auto const keyed = cmp(_mm_and_si128(sv, m), k);
+        auto const bits = _mm_movemask_epi8(keyed);
+        if (bits == 0xFFFF)
+            continue;
+        auto* const dp = reinterpret_cast<__m128i*>(d + x * Bytes);
+        if (bits == 0) {
+            _mm_storeu_si128(dp, sv);
+            continue;
+        }
+        auto const dv = _mm_loadu_si128(dp);
+        _mm_storeu_si128(dp, _mm_or_si128(_mm_and_si128(keyed, dv), _mm_andnot_si128(keyed, sv)));
+    }
+#endif
+    for (; x < n; ++x) {
+        std::uint32_t p = 0;
+        std::memcpy(&p, s + x * Bytes, Bytes);
+        if ((p & mask) != key)
+            std::memcpy(d + x * Bytes, s + x * Bytes, Bytes);
+    }
+}
+
+template<int Bytes>
+void copy_row(std::uint8_t const* const s, std::uint8_t* const d, int const n, std::uint32_t, std::uint32_t) noexcept {
+    std::memcpy(d, s, static_cast<std::size_t>(n) * Bytes);
+}
+
+struct row_kernel {
+    row_fn fn = nullptr;
+    std::uint32_t key = 0;
+    std::uint32_t mask = 0;
+};
+
+// The rows reproduce SDL's blit only when it would be a plain copy, or a keyed copy, between identical
+// formats. Like SDL, the key comparison ignores the alpha bits, so mask is ~Amask cut to the pixel size.
+row_kernel select_row(surface const& src, surface const& dst, bool const keyed) noexcept {
+    if (!src || !dst || src.native_handle() == dst.native_handle())
+        return {};
+    auto const sf = src.pixel_format(), df = dst.pixel_format();
+    auto const key = src.color_key();
+    if (sf.format() != df.format() || key.has_value() != keyed || src.alpha_mod() != 255)
+        return {};
+    if (auto const mod = src.color_mod(); mod.r != 255 || mod.g != 255 || mod.b != 255)
+        return {};
+    if (auto const mode = src.blend_mode(); mode != blend_mode::NONE && (mode != blend_mode::BLEND || sf.amask() != 0))
+        return {};
+
+    auto const bytes = sf.bytes_per_pixel();
+    auto const size_mask = bytes == 4 ? 0xFFFFFFFFu : (1u << (8 * bytes)) - 1;
+    row_kernel k{nullptr, 0, ~sf.amask() & size_mask};
+    if (key)
+        k.key = key->value() & k.mask;
+
+    switch (bytes) {
+    case 1: {
+        if (!sf.has_palette() || !df.has_palette())
+            return {};
+        auto const sp = sf.palette().colors(), dp = df.palette().colors();
+        auto const same = std::equal(sp.begin(), sp.end(), dp.begin(), dp.end(), [](SDL_Color const& a, SDL_Color const& b) {
+            return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+        });
+        k.fn = !same ? nullptr : keyed ? keyed_row<1> : copy_row<1>;
+        break;
+    }
+    case 2: k.fn = keyed ? keyed_row<2> : copy_row<2>; break;
+    case 3: k.fn = keyed ? nullptr : copy_row<3>; break;
+    case 4: k.fn = keyed ? keyed_row<4> : copy_row<4>; break;
+    default: break;
+    }
+    return k;
+}
+
+void copy_area(row_kernel const& k, surface& src, surface& dst, detail::blit_area const& area) noexcept {
+    for (int y = 0; y < area.dst.h(); ++y) {
+        auto const* const s = reinterpret_cast<std::uint8_t const*>(detail::pixel_at(std::as_const(src), area.src.x, area.src.y + y));
+        auto* const d = reinterpret_cast<std::uint8_t*>(detail::pixel_at(dst, area.dst.x(), area.dst.y() + y));
+        k.fn(s, d, area.dst.w(), k.key, k.mask);
+    }
+}
+
+bool blit_keyed_impl(surface& src, rect<int> const* const srcrect, surface& dst, rect<int>* const dstrect) noexcept {
+    auto const k = select_row(src, dst, true);
+    if (k.fn == nullptr) {
+        // SDL_BlitSurface takes the destination rect's position and writes back the clipped rect
+        return SDL_BlitSurface(src.native_handle(), srcrect ? srcrect->native_handle() : nullptr,
+                               dst.native_handle(), dstrect ? dstrect->native_handle() : nullptr) == 0;
+    }
+
+    auto const area = detail::clip_blit(src, srcrect, dst, dstrect ? xy<int>{dstrect->x(), dstrect->y()} : xy<int>{});
+    if (dstrect)
+        *dstrect = area.dst;
+    if (area.dst.empty())
+        return true;
+
+    detail::surface_lock_guard const src_lock{src};
+    detail::surface_lock_guard const dst_lock{dst};
+    if (src.pixels() == nullptr || dst.pixels() == nullptr)
+        return false;
+
+    copy_area(k, src, dst, area);
+    return true;
+}
+
+// Clips every op like clip_blit, as straight min/max arithmetic over the whole batch so the loop vectorises.
+// Ops that end up empty are dropped afterwards.
+void clip_ops(std::span<blit_op const> const ops, wh<int> const src_size, rect<int> const& clip, std::vector<detail::blit_area>& out) {
+    out.resize(ops.size());
+    auto const cx0 = clip.x(), cy0 = clip.y(), cx1 = clip.x() + clip.w(), cy1 = clip.y() + clip.h();
+    for (std::size_t i = 0; i < ops.size(); ++i) {
+        auto const& op = ops[i];
+        auto const sx0 = std::max(op.src.x(), 0), sy0 = std::max(op.src.y(), 0);
+        auto const sx1 = std::min(op.src.x() + op.src.w(), src_size.width), sy1 = std::min(op.src.y() + op.src.h(), src_size.height);
+        auto const dx0 = op.dst.x() + sx0 - op.src.x(), dy0 = op.dst.y() + sy0 - op.src.y();
+        auto const x0 = std::max(dx0, cx0), y0 = std::max(dy0, cy0);
+        auto const x1 = std::min(dx0 + sx1 - sx0, cx1), y1 = std::min(dy0 + sy1 - sy0, cy1);
+        out[i] = {{x0, y0, x1 - x0, y1 - y0}, {sx0 + x0 - dx0, sy0 + y0 - dy0}};
+    }
+    std::erase_if(out, [](detail::blit_area const& a) { return a.dst.empty(); });
+}
+
+} // namespace
+
+// blit_keyed
+bool surface::blit_keyed(rect<int> const& srcrect, surface& dst, rect<int>& dstrect) noexcept {
+    return blit_keyed_impl(*this, &srcrect, dst, &dstrect);
+}
+bool surface::blit_keyed(surface& dst, rect<int>& dstrect) noexcept {
+    return blit_keyed_impl(*this, nullptr, dst, &dstrect);
+}
+bool surface::blit_keyed(surface& dst) noexcept {
+    return blit_keyed_impl(*this, nullptr, dst, nullptr);
+}
+bool surface::blit_keyed(rect<int> const& srcrect, surface& dst) noexcept {
+    return blit_keyed_impl(*this, &srcrect, dst, nullptr);
+}
+
+bool surface::blit_keyed(rect<int> const& srcrect, surface& dst, std::span<point<int> const> const positions) noexcept {
+    auto const k = select_row(*this, dst, true);
+    if (k.fn == nullptr) {
+        bool ok = true;
+        for (auto const& p : positions) {
+            rect<int> r{p.x(), p.y(), srcrect.w(), srcrect.h()};
+            ok = blit(srcrect, dst, r) && ok;
+        }
+        return ok;
+    }
+
+    detail::surface_lock_guard const src_lock{*this};
+    detail::surface_lock_guard const dst_lock{dst};
+    if (pixels() == nullptr || dst.pixels() == nullptr)
+        return false;
+
+    for (auto const& p : positions) {
+        auto const area = detail::clip_blit(*this, &srcrect, dst, {p.x(), p.y()});
+        if (!area.dst.empty())
+            copy_area(k, *this, dst, area);
+    }
+    return true;
+}
+
+bool surface::blit_many(surface& dst, std::span<blit_op const> const ops, bool const sort) noexcept {
+    auto const k = select_row(*this, dst, color_key().has_value());
+    if (k.fn == nullptr) {
+        bool ok = true;
+        for (auto const& op : ops) {
+            rect<int> r{op.dst.x(), op.dst.y(), op.src.w(), op.src.h()};
+            ok = blit(op.src, dst, r) && ok;
+        }
+        return ok;
+    }
+
+    std::vector<detail::blit_area> areas;
+    clip_ops(ops, {width(), height()}, dst.clip_rect(), areas);
+    if (sort) {
+        std::stable_sort(areas.begin(), areas.end(), [](detail::blit_area const& a, detail::blit_area const& b) {
+            return a.dst.y() != b.dst.y() ? a.dst.y() < b.dst.y() : a.dst.x() < b.dst.x();
+        });
+    }
+    if (areas.empty())
+        return true;
+
+    detail::surface_lock_guard const src_lock{*this};
+    detail::surface_lock_guard const dst_lock{dst};
+    if (pixels() == nullptr || dst.pixels() == nullptr)
+        return false;
+
+    for (auto const& area : areas)
+        copy_area(k, *this, dst, area);
+    return true;
+}
@@ -0,0 +1,391 @@
+#include "sdl2pp/blur.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "parallel.hpp"
+#include "pixel_access.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SDL2PP_BLUR_SSE2 1
+#endif
+
+using namespace sdl2;
+
+namespace {
+
+// keeps box sums below 2^24, the range box_divider is exact over
+constexpr int max_radius = 1 << 14;
+
+// Gaussian weights sum to 1 << weight_bits, small enough for _mm_madd_epi16
+constexpr int weight_bits = 14;
+
+// the width of the column strips of the vertical pass
+constexpr std::size_t strip_bytes = 256;
+
+/**
+ * @brief Divides box sums by the box size, rounding to nearest, with a multiply and a shift.
+ * The reciprocal is rounded up to 40 bits, which makes the quotient exact for every dividend below 2^24.
+ */
+struct box_divider {
+    std::uint32_t half;
+    std::uint64_t scale;
+
+    explicit box_divider(int const radius) noexcept
+        : half{static_cast<std::uint32_t>(radius)}
+        , scale{((std::uint64_t{1} << 40) + static_cast<std::uint64_t>(2 * radius)) / static_cast<std::uint64_t>(2 * radius + 1)} {}
+
+    std::uint8_t operator()(std::uint32_t const sum) const noexcept {
+        return static_cast<std::uint8_t>((static_cast<std::uint64_t>(sum + half) * scale) >> 40);
+    }
+};
+
+/**
+ * @brief A one-dimensional kernel: a box of 2 radius + 1 pixels, or Gaussian weights.
+ */
+struct kernel {
+    int radius = 0;
+    std::vector<int> weights;
+
+    // the weights of taps 2 i and 2 i + 1 packed as the 16-bit halves of one madd operand
+    std::int32_t pair(std::size_t const i) const noexcept {
+        auto const lo = weights[2 * i];
+        auto const hi = 2 * i + 1 < weights.size() ? weights[2 * i + 1] : 0;
+        return static_cast<std::int32_t>(static_cast<std::uint32_t>(lo) | static_cast<std::uint32_t>(hi) << 16);
+    }
+};
+
+kernel box_kernel(int const radius) {
+    return {std::clamp(radius, 0, max_radius), {}};
+}
+
+kernel gaussian_kernel(float const sigma) {
+    kernel k;
+    k.radius = std::clamp(static_cast<int>(std::ceil(3.0f * sigma)), 0, max_radius);
+    if (k.radius == 0) {
+        k.weights = {1 << weight_bits};
+        return k;
+    }
+    std::vector<double> g(static_cast<std::size_t>(2 * k.radius + 1));
+    for (int i = -k.radius; i <= k.radius; ++i)
+        g[static_cast<std::size_t>(i + k.radius)] = std::exp(-0.5 * i * i / (static_cast<double>(sigma) * sigma));
+    auto const sum = std::accumulate(g.begin(), g.end(), 0.0);
+
+    // Weights are rounded down, then the units short of 1 << weight_bits go to the taps that lost the most,
+    // a mirrored pair at a time so the kernel stays symmetric; the centre takes the odd unit if there is one.
+    // Flat areas stay flat, and no tap is off by a unit or more however many taps a wide kernel has.
+    auto const centre = static_cast<std::size_t>(k.radius);
+    k.weights.resize(g.size());
+    std::vector<std::pair<double, std::size_t>> remainders;
+    remainders.reserve(centre);
+    int total = 0;
+    for (std::size_t i = 0; i < g.size(); ++i) {
+        auto const exact = g[i] / sum * (1 << weight_bits);
+        k.weights[i] = static_cast<int>(exact);
+        total += k.weights[i];
+        if (i < centre)
+            remainders.emplace_back(exact - k.weights[i], i);
+    }
+    std::stable_sort(remainders.begin(), remainders.end(), [](auto const& a, auto const& b) { return a.first > b.first; });
+    auto missing = (1 << weight_bits) - total;
+    if (missing % 2 != 0) {
+        ++k.weights[centre];
+        --missing;
+    }
+    for (auto const& [remainder, i] : remainders) {
+        if (missing == 0)
+            break;
+        ++k.weights[i];
+        ++k.weights[g.size() - 1 - i];
+        missing -= 2;
+    }
+    k.weights[centre] += missing;
+
+    // the tails of a wide kernel round to nothing; dropping them saves reading pixels they would not weigh
+    auto const zeros = static_cast<std::size_t>(std::find_if(k.weights.begin(), k.weights.end(), [](int const w) { return w != 0; }) - k.weights.begin());
+    if (zeros > 0) {
+        k.weights.erase(k.weights.end() - static_cast<std::ptrdiff_t>(zeros), k.weights.end());
+        k.weights.erase(k.weights.begin(), k.weights.begin() + static_cast<std::ptrdiff_t>(zeros));
+        k.radius -= static_cast<int>(zeros);
+    }
+    return k;
+}
+
+// The box radii of n passes whose combined variance best matches a Gaussian of the given sigma:
+// the sizes are the odd widths either side of the ideal width, mixed to get the variance right.
+std::vector<int> box_radii_for_gaussian(float const sigma, int const n) {
+    auto const s2 = 12.0 * sigma * sigma;
+    auto wl = static_cast<int>(std::floor(std::sqrt(s2 / n + 1.0)));
+    if (wl % 2 == 0)
+        --wl;
+    wl = std::max(wl, 1);
+    auto const m = static_cast<int>(std::lround((s2 - n * wl * wl - 4.0 * n * wl - 3.0 * n) / (-4.0 * wl - 4.0)));
+
+    std::vector<int> radii(static_cast<std::size_t>(n));
+    for (int i = 0; i < n; ++i)
+        radii[static_cast<std::size_t>(i)] = ((i < m ? wl : wl + 2) - 1) / 2;
+    return radii;
+}
+
+/**
+ * @brief The rows of a region, in a surface or in a scratch buffer.
+ */
+struct region_rows {
+    std::uint8_t* data = nullptr;
+    std::ptrdiff_t pitch = 0;
+
+    std::uint8_t* row(int const y) const noexcept {
+        return data + static_cast<std::ptrdiff_t>(y) * pitch;
+    }
+};
+
+struct pass_shape {
+    int width = 0;
+    int height = 0;
+    int bytes = 0;
+    blur_border border = blur_border::CLAMP;
+
+    std::size_t row_bytes() const noexcept {
+        return static_cast<std::size_t>(width) * static_cast<std::size_t>(bytes);
+    }
+};
+
+// copies a row into line with radius pixels of border on either side
+void pad_line(std::uint8_t const* const src, pass_shape const& shape, int const radius, std::uint8_t* const line) noexcept {
+    auto const bytes = static_cast<std::size_t>(shape.bytes);
+    std::memcpy(line + radius * bytes, src, shape.row_bytes());
+    auto* const right = line + (static_cast<std::size_t>(radius) + static_cast<std::size_t>(shape.width)) * bytes;
+    if (shape.border == blur_border::ZERO) {
+        std::memset(line, 0, radius * bytes);
+        std::memset(right, 0, radius * bytes);
+        return;
+    }
+    auto const* const last = src + shape.row_bytes() - bytes;
+    for (int i = 0; i < radius; ++i) {
+        std::memcpy(line + i * bytes, src, bytes);
+        std::memcpy(right + i * bytes, last, bytes);
+    }
+}
+
+void box_line(std::uint8_t const* const line, pass_shape const& shape, kernel const& k, std::uint8_t* const out) noexcept {
+    auto const bytes = static_cast<std::size_t>(shape.bytes);
+    auto const window = static_cast<std::size_t>(2 * k.radius + 1);
+    box_divider const divide{k.radius};
+    std::uint32_t acc[4]{};
+    for (std::size_t i = 0; i < window; ++i) {
+        for (std::size_t c = 0; c < bytes; ++c)
+            acc[c] += line[i * bytes + c];
+    }
+    for (std::size_t x = 0; x < static_cast<std::size_t>(shape.width); ++x) {
+        for (std::size_t c = 0; c < bytes; ++c)
+            out[x * bytes + c] = divide(acc[c]);
+        if (x + 1 == static_cast<std::size_t>(shape.width))
+            break;
+        for (std::size_t c = 0; c < bytes; ++c)
+            acc[c] += static_cast<std::uint32_t>(line[(x + window) * bytes + c]) - line[x * bytes + c];
+    }
+}
+
+// Applies Gaussian weights along a padded line. The SSE2 loop interleaves the channels of two taps and
+// weighs both with one _mm_madd_epi16; the integer sums match the scalar loop exactly.
+void gaussian_line(std::uint8_t const* const line, pass_shape const& shape, kernel const& k, std::uint8_t* const out) noexcept {
+    auto const bytes = static_cast<std::size_t>(shape.bytes);
+    auto const taps = k.weights.size();
+    std::size_t x = 0;
+#ifdef SDL2PP_BLUR_SSE2
+    if (bytes == 4) {
+        auto const zero = _mm_setzero_si128(), half = _mm_set1_epi32(1 << (weight_bits - 1));
+        auto const load = [zero](std::uint8_t const* const p) {
+            std::int32_t v;
+            std::memcpy(&v, p, 4);
+            return _mm_unpacklo_epi8(_mm_cvtsi32_si128(v), zero);
+        };
+        for (; x < static_cast<std::size_t>(shape.width); ++x) {
+            auto acc = zero;
+            for (std::size_t t = 0; t < taps; t += 2) {
+                auto const a = load(line + (x + t) * 4);
+                auto const b = t + 1 < taps ? load(line + (x + t + 1) * 4) : zero;
+                acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), _mm_set1_epi32(k.pair(t / 2))));
+            }
+            auto const v = _mm_srai_epi32(_mm_add_epi32(acc, half), weight_bits);
+            auto const px = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(v, v), zero));
+            std::memcpy(out + x * 4, &px, 4);
+        }
+    }
+#endif
+    for (; x < static_cast<std::size_t>(shape.width); ++x) {
+        for (std::size_t c = 0; c < bytes; ++c) {
+            int sum = 0;
+            for (std::size_t t = 0; t < taps; ++t)
+                sum += k.weights[t] * line[(x + t) * bytes + c];
+            out[x * bytes + c] = static_cast<std::uint8_t>(std::clamp((sum + (1 << (weight_bits - 1))) >> weight_bits, 0, 255));
+        }
+    }
+}
+
+void horizontal_pass(region_rows const in, region_rows const out, pass_shape const& shape, kernel const& k, bool const box, int const begin, int const end) {
+    std::vector<std::uint8_t> line((static_cast<std::size_t>(shape.width) + 2 * static_cast<std::size_t>(k.radius)) * static_cast<std::size_t>(shape.bytes));
+    for (int y = begin; y < end; ++y) {
+        pad_line(in.row(y), shape, k.radius, line.data());
+        if (box)
+            box_line(line.data(), shape, k, out.row(y));
+        else
+            gaussian_line(line.data(), shape, k, out.row(y));
+    }
+}
+
+// Slides a box down the columns of each strip: every output row adds the row entering the window and
+// subtracts the one leaving it. rows holds the input rows from -radius to height + radius - 1.
+void box_columns(std::uint8_t const* const* const rows, region_rows const out, pass_shape const& shape, kernel const& k, int const begin, int const end) {
+    auto const window = 2 * k.radius + 1;
+    box_divider const divide{k.radius};
+    std::vector<std::uint32_t> sums(strip_bytes);
+    for (std::size_t x0 = 0; x0 < shape.row_bytes(); x0 += strip_bytes) {
+        auto const n = std::min(strip_bytes, shape.row_bytes() - x0);
+        auto* __restrict const acc = sums.data();
+        std::fill_n(acc, n, 0u);
+        for (int i = 0; i < window; ++i) {
+            auto const* __restrict const r = rows[begin + i] + x0;
+            for (std::size_t x = 0; x < n; ++x)
+                acc[x] += r[x];
+        }
+        for (int y = begin; y < end; ++y) {
+            auto* __restrict const o = out.row(y) + x0;
+            for (std::size_t x = 0; x < n; ++x)
+                o[x] = divide(acc[x]);
+            if (y + 1 == end)
+                break;
+            auto const* __restrict const enter = rows[y + window] + x0;
+            auto const* __restrict const leave = rows[y] + x0;
+            for (std::size_t x = 0; x < n; ++x)
+                acc[x] += static_cast<std::uint32_t>(enter[x]) - leave[x];
+        }
+    }
+}
+
+// Applies Gaussian weights down the columns of each strip, 16 bytes at a time with SSE2.
+void gaussian_columns(std::uint8_t const* const* const rows, region_rows const out, pass_shape const& shape, kernel const& k, int const begin, int const end) {
+    auto const taps = k.weights.size();
+    for (std::size_t x0 = 0; x0 < shape.row_bytes(); x0 += strip_bytes) {
+        auto const x1 = std::min(x0 + strip_bytes, shape.row_bytes());
+        for (int y = begin; y < end; ++y) {
+            auto* const o = out.row(y);
+            auto const* const* const window = rows + y;
+            auto x = x0;
+#ifdef SDL2PP_BLUR_SSE2
+            auto const zero = _mm_setzero_si128(), half = _mm_set1_epi32(1 << (weight_bits - 1));
+            for (; x + 16 <= x1; x += 16) {
+                __m128i acc[4]{zero, zero, zero, zero};
+                for (std::size_t t = 0; t < taps; t += 2) {
+                    auto const w = _mm_set1_epi32(k.pair(t / 2));
+                    auto const a = _mm_loadu_si128(reinterpret_cast<__m128i const*>(window[t] + x));
+                    auto const b = t + 1 < taps ? _mm_loadu_si128(reinterpret_cast<__m128i const*>(window[t + 1] + x)) : zero;
+                    auto const alo = _mm_unpacklo_epi8(a, zero), ahi = _mm_unpackhi_epi8(a, zero);
+                    auto const blo = _mm_unpacklo_epi8(b, zero), bhi = _mm_unpackhi_epi8(b, zero);
+                    acc[0] = _mm_add_epi32(acc[0], _mm_madd_epi16(_mm_unpacklo_epi16(alo, blo), w));
+                    acc[1] = _mm_add_epi32(acc[1], _mm_madd_epi16(_mm_unpackhi_epi16(alo, blo), w));
+                    acc[2] = _mm_add_epi32(acc[2], _mm_madd_epi16(_mm_unpacklo_epi16(ahi, bhi), w));
+                    acc[3] = _mm_add_epi32(acc[3], _mm_madd_epi16(_mm_unpackhi_epi16(ahi, bhi), w));
+                }
+                for (auto& v : acc)
+                    v = _mm_srai_epi32(_mm_add_epi32(v, half), weight_bits);
+                auto const px = _mm_packus_epi16(_mm_packs_epi32(acc[0], acc[1]), _mm_packs_epi32(acc[2], acc[3]));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(o + x), px);
+            }
+#endif
+            for (; x < x1; ++x) {
+                int sum = 0;
+                for (std::size_t t = 0; t < taps; ++t)
+                    sum += k.weights[t] * window[t][x];
+                o[x] = static_cast<std::uint8_t>(std::clamp((sum + (1 << (weight_bits - 1))) >> weight_bits, 0, 255));
+            }
+        }
+    }
+}
+
+// one separable pass: in's rows into scratch, then scratch's columns into out, which may be in
+void blur_pass(region_rows const in, region_rows const out, pass_shape const& shape, kernel const& k, bool const box,
+               std::vector<std::uint8_t>& scratch, std::vector<std::uint8_t> const& zero_row, std::size_t const threads) {
+    region_rows const mid{scratch.data(), static_cast<std::ptrdiff_t>(shape.row_bytes())};
+    auto const row_pixels = static_cast<std::size_t>(shape.width) * static_cast<std::size_t>(2 * k.radius + 1);
+    detail::parallel_rows(shape.height, row_pixels, threads, [&](int const begin, int const end) {
+        horizontal_pass(in, mid, shape, k, box, begin, end);
+    });
+
+    std::vector<std::uint8_t const*> rows(static_cast<std::size_t>(shape.height) + 2 * static_cast<std::size_t>(k.radius));
+    for (int i = 0; i < static_cast<int>(rows.size()); ++i) {
+        auto const y = i - k.radius;
+        if (y >= 0 && y < shape.height)
+            rows[static_cast<std::size_t>(i)] = mid.row(y);
+        else if (shape.border == blur_border::ZERO)
+            rows[static_cast<std::size_t>(i)] = zero_row.data();
+        else
+            rows[static_cast<std::size_t>(i)] = mid.row(std::clamp(y, 0, shape.height - 1));
+    }
+    detail::parallel_rows(shape.height, row_pixels, threads, [&](int const begin, int const end) {
+        if (box)
+            box_columns(rows.data(), out, shape, k, begin, end);
+        else
+            gaussian_columns(rows.data(), out, shape, k, begin, end);
+    });
+}
+
+bool blur_impl(surface const& src, surface& dst, blur_options const& options, std::optional<rect<int>> const& area) {
+    if (!src || !dst || src.width() != dst.width() || src.height() != dst.height() || src.pixel_format().format() != dst.pixel_format().format())
+        return false;
+    auto const layout = detail::get_byte_layout(src.pixel_format());
+    if (!layout)
+        return false;
+    auto const full = rect<int>{0, 0, src.width(), src.height()};
+    auto const clipped = area ? area->intersection(full) : std::optional{full};
+    if (!clipped || clipped->empty())
+        return true;
+
+    std::vector<kernel> passes;
+    switch (options.filter) {
+    case blur_filter::BOX:
+        passes.push_back(box_kernel(static_cast<int>(std::lround(options.radius))));
+        break;
+    case blur_filter::ITERATED_BOX:
+        for (auto const r : box_radii_for_gaussian(std::max(options.radius, 0.0f), std::max(options.iterations, 1)))
+            passes.push_back(box_kernel(r));
+        break;
+    case blur_filter::GAUSSIAN:
+        passes.push_back(gaussian_kernel(std::max(options.radius, 0.0f)));
+        break;
+    }
+    auto const box = options.filter != blur_filter::GAUSSIAN;
+
+    auto const same = &src == &dst;
+    detail::surface_lock_guard const lock_src{const_cast<surface&>(src)};
+    std::optional<detail::surface_lock_guard> lock_dst;
+    if (!same)
+        lock_dst.emplace(dst);
+    if (src.pixels() == nullptr || dst.pixels() == nullptr)
+        return false;
+
+    pass_shape const shape{clipped->w(), clipped->h(), layout->bytes, options.border};
+    region_rows const in{reinterpret_cast<std::uint8_t*>(const_cast<std::byte*>(detail::pixel_at(src, clipped->x(), clipped->y()))), src.pitch()};
+    region_rows const out{reinterpret_cast<std::uint8_t*>(detail::pixel_at(dst, clipped->x(), clipped->y())), dst.pitch()};
+    std::vector<std::uint8_t> scratch(shape.row_bytes() * static_cast<std::size_t>(shape.height));
+    std::vector<std::uint8_t> const zero_row(shape.row_bytes());
+    for (std::size_t i = 0; i < passes.size(); ++i)
+        blur_pass(i == 0 ? in : out, out, shape, passes[i], box, scratch, zero_row, options.threads);
+    return true;
+}
+
+} // namespace
+
+bool sdl2::blur(surface& s, blur_options const& options, std::optional<rect<int>> const area) {
+    return blur_impl(s, s, options, area);
+}
+
+bool sdl2::blur(surface const& src, surface& dst, blur_options const& options, std::optional<rect<int>> const area) {
+    return blur_impl(src, dst, options, area);
+}
@@ -0,0 +1,387 @@
+#include "sdl2pp/surface.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include "pixel_access.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SDL2PP_COMPOSITE_SSE2 1
+#endif
+
+using namespace sdl2;
+
+namespace {
+
+// The operators are written once against the handful of primitives below, which exist both for
+// a single channel held in an int and for eight 16-bit channels in an SSE2 register. Both paths
+// therefore perform the same integer operations and produce identical bytes. All channel values
+// are premultiplied and in [0, 255] whenever they reach mul().
+
+int mul(int const a, int const b) noexcept { return static_cast<int>(detail::div255(static_cast<std::uint32_t>(a * b))); }
+int add(int const a, int const b) noexcept { return a + b; }
+int sub(int const a, int const b) noexcept { return a - b; }
+int sub_sat(int const a, int const b) noexcept { return std::max(a - b, 0); }
+int inv(int const a) noexcept { return 255 - a; }
+int select_le(int const a, int const b, int const x, int const y) noexcept { return a <= b ? x : y; }
+
+#ifdef SDL2PP_COMPOSITE_SSE2
+using reg = __m128i;
+
+reg mul(reg const a, reg const b) noexcept {
+    auto const t = _mm_add_epi16(_mm_mullo_epi16(a, b), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+reg add(reg const a, reg const b) noexcept { return _mm_add_epi16(a, b); }
+reg sub(reg const a, reg const b) noexcept { return _mm_sub_epi16(a, b); }
+reg sub_sat(reg const a, reg const b) noexcept { return _mm_subs_epu16(a, b); }
+reg inv(reg const a) noexcept { return _mm_sub_epi16(_mm_set1_epi16(255), a); }
+reg select_le(reg const a, reg const b, reg const x, reg const y) noexcept {
+    auto const gt = _mm_cmpgt_epi16(a, b);
+    return _mm_or_si128(_mm_and_si128(gt, y), _mm_andnot_si128(gt, x));
+}
+#endif
+
+enum class factor { zero, one, src_alpha, dst_alpha, inv_src_alpha, inv_dst_alpha };
+
+template<factor F, class V>
+V scale(V const c, V const sa, V const da) noexcept {
+    if constexpr (F == factor::one) return c;
+    else if constexpr (F == factor::src_alpha) return mul(c, sa);
+    else if constexpr (F == factor::dst_alpha) return mul(c, da);
+    else if constexpr (F == factor::inv_src_alpha) return mul(c, inv(sa));
+    else return mul(c, inv(da));
+}
+
+// s * Fa + d * Fb
+template<factor Fa, factor Fb, class V>
+V porter_duff(V const s, V const d, V const sa, V const da) noexcept {
+    if constexpr (Fa == factor::zero && Fb == factor::zero) return sub(s, s);
+    else if constexpr (Fa == factor::zero) return scale<Fb>(d, sa, da);
+    else if constexpr (Fb == factor::zero) return scale<Fa>(s, sa, da);
+    else return add(scale<Fa>(s, sa, da), scale<Fb>(d, sa, da));
+}
+
+template<composite_op Op>
+constexpr bool is_porter_duff = Op != composite_op::MULTIPLY && Op != composite_op::SCREEN && Op != composite_op::OVERLAY;
+
+// result color channel; may leave [0, 255] and is clamped by the caller
+template<composite_op Op, class V>
+V blend_color(V const s, V const d, V const sa, V const da) noexcept {
+    using enum factor;
+    if constexpr (Op == composite_op::CLEAR) return porter_duff<zero, zero>(s, d, sa, da);
+    else if constexpr (Op == composite_op::SRC) return porter_duff<one, zero>(s, d, sa, da);
+    else if constexpr (Op == composite_op::DST) return porter_duff<zero, one>(s, d, sa, da);
+    else if constexpr (Op == composite_op::SRC_OVER) return porter_duff<one, inv_src_alpha>(s, d, sa, da);
+    else if constexpr (Op == composite_op::DST_OVER) return porter_duff<inv_dst_alpha, one>(s, d, sa, da);
+    else if constexpr (Op == composite_op::SRC_IN) return porter_duff<dst_alpha, zero>(s, d, sa, da);
+    else if constexpr (Op == composite_op::DST_IN) return porter_duff<zero, src_alpha>(s, d, sa, da);
+    else if constexpr (Op == composite_op::SRC_OUT) return porter_duff<inv_dst_alpha, zero>(s, d, sa, da);
+    else if constexpr (Op == composite_op::DST_OUT) return porter_duff<zero, inv_src_alpha>(s, d, sa, da);
+    else if constexpr (Op == composite_op::SRC_ATOP) return porter_duff<dst_alpha, inv_src_alpha>(s, d, sa, da);
+    else if constexpr (Op == composite_op::DST_ATOP) return porter_duff<inv_dst_alpha, src_alpha>(s, d, sa, da);
+    else if constexpr (Op == composite_op::XOR) return porter_duff<inv_dst_alpha, inv_src_alpha>(s, d, sa, da);
+    else if constexpr (Op == composite_op::PLUS) return porter_duff<one, one>(s, d, sa, da);
+    else if constexpr (Op == composite_op::MULTIPLY) {
+        return add(mul(s, d), add(mul(s, inv(da)), mul(d, inv(sa))));
+    } else if constexpr (Op == composite_op::SCREEN) {
+        return sub(add(s, d), mul(s, d));
+    } else {
+        // overlay is hard light with the layers swapped: multiply where the backdrop is dark, screen where light
+        auto const sd = mul(s, d);
+        auto const m = mul(sub_sat(da, d), sub_sat(sa, s));
+        auto const hard = select_le(add(d, d), da, add(sd, sd), sub(mul(sa, da), add(m, m)));
+        return add(add(mul(s, inv(da)), mul(d, inv(sa))), hard);
+    }
+}
+
+template<composite_op Op, class V>
+V blend_alpha(V const sa, V const da) noexcept {
+    if constexpr (is_porter_duff<Op>)
+        return blend_color<Op>(sa, da, sa, da);
+    else
+        return sub(add(sa, da), mul(sa, da));
+}
+
+/**
+ * Pixels are processed in the destination's byte order; alpha is the byte holding alpha (or the
+ * padding byte when the destination has none) and the or-masks force that byte to 255 for
+ * surfaces without an alpha channel.
+ */
+struct kernel_params {
+    int alpha;
+    bool straight;
+    std::uint8_t s_or[4];
+    std::uint8_t d_or[4];
+};
+
+template<composite_op Op>
+void composite_pixel(std::uint8_t const* const s, std::uint8_t* const d, kernel_params const& p) noexcept {
+    int sc[4], dc[4], out[4];
+    for (int k = 0; k < 4; ++k) {
+        sc[k] = s[k] | p.s_or[k];
+        dc[k] = d[k] | p.d_or[k];
+    }
+    auto const sa = sc[p.alpha], da = dc[p.alpha];
+    if (p.straight) {
+        for (int k = 0; k < 4; ++k) {
+            if (k != p.alpha) {
+                sc[k] = mul(sc[k], sa);
+                dc[k] = mul(dc[k], da);
+            }
+        }
+    }
+    for (int k = 0; k < 4; ++k)
+        out[k] = std::clamp(k == p.alpha ? blend_alpha<Op>(sa, da) : blend_color<Op>(sc[k], dc[k], sa, da), 0, 255);
+    auto const a = static_cast<std::uint8_t>(out[p.alpha]);
+    for (int k = 0; k < 4; ++k) {
+        auto const c = static_cast<std::uint8_t>(out[k]);
+        d[k] = p.straight && k != p.alpha ? detail::unpremultiply_channel(c, a) : c;
+    }
+}
+
+#ifdef SDL2PP_COMPOSITE_SSE2
+// broadcast the alpha lane of each pixel (four 16-bit lanes) across that pixel
+reg spread(reg x) noexcept {
+    x = _mm_or_si128(x, _mm_or_si128(_mm_slli_epi64(x, 16), _mm_srli_epi64(x, 16)));
+    return _mm_or_si128(x, _mm_or_si128(_mm_slli_epi64(x, 32), _mm_srli_epi64(x, 32)));
+}
+
+// the given byte of every pixel set to 0xFF
+reg alpha_lane_mask(int const alpha) noexcept {
+    std::uint32_t a_bytes = 0;
+    reinterpret_cast<std::uint8_t*>(&a_bytes)[alpha] = 0xFF;
+    return _mm_set1_epi32(static_cast<int>(a_bytes));
+}
+
+template<composite_op Op>
+reg composite_half(reg s, reg d, reg const amask, bool const straight) noexcept {
+    auto const sa = spread(_mm_and_si128(s, amask));
+    auto const da = spread(_mm_and_si128(d, amask));
+    if (straight) {
+        s = _mm_or_si128(_mm_and_si128(amask, s), _mm_andnot_si128(amask, mul(s, sa)));
+        d = _mm_or_si128(_mm_and_si128(amask, d), _mm_andnot_si128(amask, mul(d, da)));
+    }
+    auto const c = blend_color<Op>(s, d, sa, da);
+    auto const a = blend_alpha<Op>(sa, da);
+    return _mm_or_si128(_mm_and_si128(amask, a), _mm_andnot_si128(amask, c));
+}
+
+// four pixels per iteration, two per register once widened to 16 bits; returns the pixels done
+template<composite_op Op>
+int composite_row_sse2(std::uint8_t const* const s, std::uint8_t* const d, int const n, kernel_params const& p) noexcept {
+    std::uint32_t s_or, d_or;
+    std::memcpy(&s_or, p.s_or, 4);
+    std::memcpy(&d_or, p.d_or, 4);
+
+    auto const zero = _mm_setzero_si128();
+    auto const sor = _mm_set1_epi32(static_cast<int>(s_or));
+    auto const dor = _mm_set1_epi32(static_cast<int>(d_or));
+    auto const abyte = alpha_lane_mask(p.alpha);
+    auto const amask = _mm_unpacklo_epi8(abyte, abyte);
+
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        auto* const q = reinterpret_cast<__m128i*>(d + 4 * i);
+        auto const sv = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<__m128i const*>(s + 4 * i)), sor);
+        auto const dv = _mm_or_si128(_mm_loadu_si128(q), dor);
+        auto const lo = composite_half<Op>(_mm_unpacklo_epi8(sv, zero), _mm_unpacklo_epi8(dv, zero), amask, p.straight);
+        auto const hi = composite_half<Op>(_mm_unpackhi_epi8(sv, zero), _mm_unpackhi_epi8(dv, zero), amask, p.straight);
+        auto const r = _mm_packus_epi16(lo, hi);
+        _mm_storeu_si128(q, r);
+
+        // straight output needs dividing by alpha, which only matters for translucent results
+        if (p.straight && _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(r, abyte), abyte)) != 0xFFFF) {
+            auto* const px = d + 4 * i;
+            for (int j = 0; j < 16; j += 4) {
+                auto const a = px[j + p.alpha];
+                for (int k = 0; k < 4; ++k) {
+                    if (k != p.alpha)
+                        px[j + k] = detail::unpremultiply_channel(px[j + k], a);
+                }
+            }
+        }
+    }
+    return i;
+}
+#endif
+
+template<composite_op Op>
+void composite_row(std::uint8_t const* const s, std::uint8_t* const d, int const n, kernel_params const& p) noexcept {
+    int i = 0;
+#ifdef SDL2PP_COMPOSITE_SSE2
+    i = composite_row_sse2<Op>(s, d, n, p);
+#endif
+    for (; i < n; ++i)
+        composite_pixel<Op>(s + 4 * i, d + 4 * i, p);
+}
+
+using row_fn = void (*)(std::uint8_t const*, std::uint8_t*, int, kernel_params const&) noexcept;
+
+row_fn select_row(composite_op const op) noexcept {
+    switch (op) {
+    case composite_op::CLEAR: return composite_row<composite_op::CLEAR>;
+    case composite_op::SRC: return composite_row<composite_op::SRC>;
+    case composite_op::DST: return composite_row<composite_op::DST>;
+    case composite_op::SRC_OVER: return composite_row<composite_op::SRC_OVER>;
+    case composite_op::DST_OVER: return composite_row<composite_op::DST_OVER>;
+    case composite_op::SRC_IN: return composite_row<composite_op::SRC_IN>;
+    case composite_op::DST_IN: return composite_row<composite_op::DST_IN>;
+    case composite_op::SRC_OUT: return composite_row<composite_op::SRC_OUT>;
+    case composite_op::DST_OUT: return composite_row<composite_op::DST_OUT>;
+    case composite_op::SRC_ATOP: return composite_row<composite_op::SRC_ATOP>;
+    case composite_op::DST_ATOP: return composite_row<composite_op::DST_ATOP>;
+    case composite_op::XOR: return composite_row<composite_op::XOR>;
+    case composite_op::PLUS: return composite_row<composite_op::PLUS>;
+    case composite_op::MULTIPLY: return composite_row<composite_op::MULTIPLY>;
+    case composite_op::SCREEN: return composite_row<composite_op::SCREEN>;
+    case composite_op::OVERLAY: return composite_row<composite_op::OVERLAY>;
+    }
+    return nullptr;
+}
+
+bool composite_impl(surface& src, rect<int> const* const srcrect, surface& dst, rect<int>* const dstrect,
+                    composite_op const op, alpha_format const alpha) noexcept {
+    if (!src || !dst)
+        return false;
+    auto const sl = detail::get_byte_layout(src.pixel_format());
+    auto const dl = detail::get_byte_layout(dst.pixel_format());
+    auto const row = select_row(op);
+    if (!sl || !dl || sl->bytes != 4 || dl->bytes != 4 || row == nullptr)
+        return false;
+
+    auto const [out, from] = detail::clip_blit(src, srcrect, dst, dstrect ? xy<int>{dstrect->x(), dstrect->y()} : xy<int>{});
+    if (dstrect)
+        *dstrect = out;
+    if (out.empty())
+        return true;
+
+    detail::surface_lock_guard const src_lock{src};
+    detail::surface_lock_guard const dst_lock{dst};
+    if (src.pixels() == nullptr || dst.pixels() == nullptr)
+        return false;
+
+    kernel_params p{};
+    p.alpha = dl->a >= 0 ? dl->a : 6 - dl->r - dl->g - dl->b;
+    p.straight = alpha == alpha_format::STRAIGHT;
+    if (dl->a < 0)
+        p.d_or[p.alpha] = 0xFF;
+
+    // sources with a different channel order are reordered one row at a time into dst's order
+    auto const same_order = sl->r == dl->r && sl->g == dl->g && sl->b == dl->b;
+    if (same_order && sl->a < 0)
+        p.s_or[p.alpha] = 0xFF;
+    std::vector<std::uint8_t> scratch(same_order ? 0 : static_cast<std::size_t>(out.w()) * 4);
+
+    for (int y = 0; y < out.h(); ++y) {
+        auto const* s = reinterpret_cast<std::uint8_t const*>(detail::pixel_at(std::as_const(src), from.x, from.y + y));
+        auto* const d = reinterpret_cast<std::uint8_t*>(detail::pixel_at(dst, out.x(), out.y() + y));
+        if (!same_order) {
+            for (int x = 0; x < out.w(); ++x) {
+                auto const* sp = s + 4 * x;
+                auto* const o = scratch.data() + 4 * x;
+                o[dl->r] = sp[sl->r];
+                o[dl->g] = sp[sl->g];
+                o[dl->b] = sp[sl->b];
+                o[p.alpha] = sl->a >= 0 ? sp[sl->a] : 0xFF;
+            }
+            s = scratch.data();
+        }
+        row(s, d, out.w(), p);
+    }
+    return true;
+}
+
+void premultiply_row(std::uint8_t* const p, int const n, int const alpha) noexcept {
+    int i = 0;
+#ifdef SDL2PP_COMPOSITE_SSE2
+    auto const zero = _mm_setzero_si128();
+    auto const abyte = alpha_lane_mask(alpha);
+    auto const amask = _mm_unpacklo_epi8(abyte, abyte);
+    auto const half = [amask](reg const c) {
+        return _mm_or_si128(_mm_and_si128(amask, c), _mm_andnot_si128(amask, mul(c, spread(_mm_and_si128(c, amask)))));
+    };
+    for (; i + 4 <= n; i += 4) {
+        auto* const q = reinterpret_cast<__m128i*>(p + 4 * i);
+        auto const v = _mm_loadu_si128(q);
+        _mm_storeu_si128(q, _mm_packus_epi16(half(_mm_unpacklo_epi8(v, zero)), half(_mm_unpackhi_epi8(v, zero))));
+    }
+#endif
+    for (; i < n; ++i) {
+        auto* const px = p + 4 * i;
+        for (int k = 0; k < 4; ++k) {
+            if (k != alpha)
+                px[k] = static_cast<std::uint8_t>(mul(px[k], px[alpha]));
+        }
+    }
+}
+
+void unpremultiply_row(std::uint8_t* const p, int const n, int const alpha) noexcept {
+    int i = 0;
+#ifdef SDL2PP_COMPOSITE_SSE2
+    // division has no SSE2 form, so only skip runs of opaque pixels here
+    auto const abyte = alpha_lane_mask(alpha);
+    for (; i + 4 <= n; i += 4) {
+        auto const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + 4 * i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(v, abyte), abyte)) == 0xFFFF)
+            continue;
+        for (int j = i; j < i + 4; ++j) {
+            auto* const px = p + 4 * j;
+            for (int k = 0; k < 4; ++k) {
+                if (k != alpha)
+                    px[k] = detail::unpremultiply_channel(px[k], px[alpha]);
+            }
+        }
+    }
+#endif
+    for (; i < n; ++i) {
+        auto* const px = p + 4 * i;
+        for (int k = 0; k < 4; ++k) {
+            if (k != alpha)
+                px[k] = detail::unpremultiply_channel(px[k], px[alpha]);
+        }
+    }
+}
+
+template<class RowFn>
+bool convert_alpha(surface& s, RowFn&& row) noexcept {
+    if (!s)
+        return false;
+    auto const fmt = s.pixel_format();
+    if (fmt.amask() == 0 && !fmt.has_palette())
+        return true;
+    auto const l = detail::get_byte_layout(fmt);
+    if (!l || l->bytes != 4 || l->a < 0)
+        return false;
+
+    detail::surface_lock_guard const lock{s};
+    if (s.pixels() == nullptr)
+        return false;
+    for (int y = 0; y < s.height(); ++y)
+        row(reinterpret_cast<std::uint8_t*>(detail::pixel_at(s, 0, y)), s.width(), l->a);
+    return true;
+}
+
+} // namespace
+
+bool surface::premultiply_alpha() noexcept {
+    return convert_alpha(*this, premultiply_row);
+}
+
+bool surface::unpremultiply_alpha() noexcept {
+    return convert_alpha(*this, unpremultiply_row);
+}
+
+bool surface::composite(rect<int> const& srcrect, surface& dst, rect<int>& dstrect, composite_op const op, alpha_format const alpha) noexcept {
+    return composite_impl(*this, &srcrect, dst, &dstrect, op, alpha);
+}
+bool surface::composite(surface& dst, rect<int>& dstrect, composite_op const op, alpha_format const alpha) noexcept {
+    return composite_impl(*this, nullptr, dst, &dstrect, op, alpha);
+}
+bool surface::composite(surface& dst, composite_op const op, alpha_format const alpha) noexcept {
+    return composite_impl(*this, nullptr, dst, nullptr, op, alpha);
+}
+bool surface::composite(rect<int> const& srcrect, surface& dst, composite_op const op, alpha_format const alpha) noexcept {
+    return composite_impl(*this, &srcrect, dst, nullptr, op, alpha);
+}
@@ -0,0 +1,144 @@
+#include "sdl2pp/dirty_region.hpp"
+
+#include <algorithm>
+#include <limits>
+
+using namespace sdl2;
+
+namespace {
+
+constexpr long long area_of(rect<int> const& r) noexcept {
+    return static_cast<long long>(r.w()) * static_cast<long long>(r.h());
+}
+
+constexpr long long overlap_area(rect<int> const& a, rect<int> const& b) noexcept {
+    auto const i = a.intersection(b);
+    return i ? area_of(*i) : 0;
+}
+
+// number of pixels the bounding rect of a and b covers that neither of them does
+constexpr long long merge_waste(rect<int> const& a, rect<int> const& b) noexcept {
+    return area_of(a.united(b)) - (area_of(a) + area_of(b) - overlap_area(a, b));
+}
+
+// The window surface is in pixels, which on high-DPI displays is more than the window size in screen
+// coordinates. Getting it creates the surface if needed, which flush() would do anyway.
+wh<int> window_surface_size(window const& win) noexcept {
+    auto const* const s = SDL_GetWindowSurface(win.native_handle());
+    return s ? wh<int>{s->w, s->h} : wh<int>{0, 0};
+}
+
+} // namespace
+
+dirty_region::dirty_region(wh<int> const bounds, std::size_t const max_rects,
+                           float const merge_waste, float const full_update_ratio)
+    : bounds_{bounds}
+    , max_rects_{std::max<std::size_t>(max_rects, 1)}
+    , merge_waste_{merge_waste}
+    , full_update_ratio_{full_update_ratio}
+{
+    rects_.reserve(max_rects_ + 1);
+}
+
+dirty_region::dirty_region(window const& win, std::size_t const max_rects)
+    : dirty_region(window_surface_size(win), max_rects)
+{}
+
+void dirty_region::add(rect<int> const& r) noexcept {
+    auto const clipped = r.intersection({0, 0, bounds_.width, bounds_.height});
+    if (!clipped)
+        return;
+
+    insert(*clipped);
+    if (rects_.size() > max_rects_)
+        collapse();
+}
+
+void dirty_region::add_all() noexcept {
+    rects_.clear();
+    if (bounds_.width > 0 && bounds_.height > 0)
+        rects_.emplace_back(0, 0, bounds_.width, bounds_.height);
+}
+
+void dirty_region::insert(rect<int> r) noexcept {
+    // keep absorbing neighbours until the grown rect no longer qualifies for a merge
+    for (bool merged = true; merged;) {
+        merged = false;
+        for (auto it = rects_.begin(); it != rects_.end(); ++it) {
+            auto const u = it->united(r);
+            if (static_cast<float>(merge_waste(*it, r)) <= merge_waste_ * static_cast<float>(area_of(u))) {
+                r = u;
+                rects_.erase(it);
+                merged = true;
+                break;
+            }
+        }
+    }
+    rects_.push_back(r);
+}
+
+void dirty_region::collapse() noexcept {
+    while (rects_.size() > max_rects_) {
+        std::size_t best_i = 0, best_j = 1;
+        auto best = std::numeric_limits<long long>::max();
+        for (std::size_t i = 0; i < rects_.size(); ++i) {
+            for (std::size_t j = i + 1; j < rects_.size(); ++j) {
+                if (auto const w = merge_waste(rects_[i], rects_[j]); w < best) {
+                    best = w;
+                    best_i = i;
+                    best_j = j;
+                }
+            }
+        }
+        auto const u = rects_[best_i].united(rects_[best_j]);
+        rects_.erase(rects_.begin() + static_cast<std::ptrdiff_t>(best_j));
+        rects_.erase(rects_.begin() + static_cast<std::ptrdiff_t>(best_i));
+        insert(u);
+    }
+}
+
+bool dirty_region::blit(surface& src, rect<int> const& srcrect, surface& dst, rect<int>& dstrect) noexcept {
+    if (!src.blit(srcrect, dst, dstrect))
+        return false;
+    add(dstrect);
+    return true;
+}
+
+bool dirty_region::blit(surface& src, surface& dst, rect<int>& dstrect) noexcept {
+    if (!src.blit(dst, dstrect))
+        return false;
+    add(dstrect);
+    return true;
+}
+
+bool dirty_region::fill_rect(surface& dst, rect<int> const& r, pixel_value const color) noexcept {
+    if (!dst.fill_rect(r, color))
+        return false;
+    add(r);
+    return true;
+}
+
+bool dirty_region::flush(window& win) noexcept {
+    if (rects_.empty())
+        return true;
+    auto const ok = prefers_full_update() ? win.update_surface() : win.update_surface_rects(rects_);
+    rects_.clear();
+    return ok;
+}
+
+void dirty_region::resize(wh<int> const bounds) noexcept {
+    bounds_ = bounds;
+    rects_.clear();
+}
+
+long long dirty_region::area() const noexcept {
+    long long total = 0;
+    for (auto const& r : rects_)
+        total += area_of(r);
+    return total;
+}
+
+bool dirty_region::prefers_full_update() const noexcept {
+    auto const full = static_cast<long long>(bounds_.width) * bounds_.height;
+    return full > 0 && static_cast<float>(area()) >= full_update_ratio_ * static_cast<float>(full);
+}
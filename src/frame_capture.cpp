@@ -0,0 +1,108 @@
+#include "sdl2pp/frame_capture.hpp"
+#include "sdl2pp/renderer.hpp"
+
+#include <algorithm>
+#include <utility>
+
+using namespace sdl2;
+
+frame_capture::frame_capture(renderer& r, wh<int> const size, std::size_t const depth, pixel_format_enum const format)
+    : renderer_{r}
+    , size_{size}
+    , format_{static_cast<std::uint32_t>(format)}
+    , staging_pitch_{size.width * static_cast<int>(SDL_BYTESPERPIXEL(static_cast<std::uint32_t>(format)))}
+{
+    SDL2_ASSERT(depth >= 2 && !SDL_ISPIXELFORMAT_FOURCC(format_));
+
+    auto const count = std::max<std::size_t>(depth, 2);
+    targets_.reserve(count);
+    while (targets_.size() < count) {
+        auto& t = targets_.emplace_back(r, format, texture_access::TARGET, size);
+        if (!t) {
+            targets_.clear();
+            return;
+        }
+    }
+
+    auto const bytes = static_cast<std::size_t>(staging_pitch_) * static_cast<std::size_t>(size.height);
+    staging_[0].resize(bytes);
+    staging_[1].resize(bytes);
+    worker_ = std::thread{&frame_capture::run, this};
+}
+
+frame_capture::~frame_capture() noexcept {
+    if (!worker_.joinable())
+        return;
+    {
+        std::lock_guard lock{mutex_};
+        stop_ = true;
+    }
+    cv_.notify_all();
+    worker_.join();
+}
+
+void frame_capture::run() noexcept {
+    std::unique_lock lock{mutex_};
+    for (;;) {
+        cv_.wait(lock, [this] { return stop_ || pending_.has_value(); });
+        if (!pending_)
+            return;
+
+        auto const j = *std::exchange(pending_, std::nullopt);
+        busy_ = true;
+        lock.unlock();
+        // SDL_ConvertPixels touches nothing but the two buffers, so it is safe off the render thread
+        auto const converted = SDL_ConvertPixels(size_.width, size_.height, format_, j.src, j.src_pitch, j.dst_format, j.dst, j.dst_pitch) == 0;
+        lock.lock();
+        busy_ = false;
+        ok_ = ok_ && converted;
+        cv_.notify_all();
+    }
+}
+
+bool frame_capture::wait() noexcept {
+    std::unique_lock lock{mutex_};
+    cv_.wait(lock, [this] { return !pending_ && !busy_; });
+    return std::exchange(ok_, true);
+}
+
+bool frame_capture::begin_frame() noexcept {
+    SDL2_ASSERT(!targets_.empty());
+    ++frames_;
+    return renderer_.set_render_target(targets_[next_]);
+}
+
+std::optional<std::uint64_t> frame_capture::end_frame(void* const pixels, int const pitch, pixel_format_enum const fmt) noexcept {
+    SDL2_ASSERT(!targets_.empty() && frames_ > 0);
+    auto const& drawn = targets_[next_];
+    next_ = (next_ + 1) % targets_.size();
+
+    if (!renderer_.reset_render_target())
+        return {};
+    renderer_.copy(drawn);
+    if (frames_ < targets_.size())
+        return {};
+
+    // the slot drawn into next holds the oldest frame in the ring
+    auto const dst_format = static_cast<std::uint32_t>(fmt);
+    auto const direct = dst_format == format_;
+    auto& staging = staging_[frames_ & 1];
+    auto const read = renderer_.set_render_target(targets_[next_])
+        && SDL_RenderReadPixels(renderer_.native_handle(), nullptr, format_, direct ? pixels : staging.data(), direct ? pitch : staging_pitch_) == 0;
+    renderer_.reset_render_target();
+    if (!read)
+        return {};
+
+    auto const frame = frames_ - targets_.size();
+    if (direct)
+        return frame;
+
+    // the worker may still be converting the previous frame out of the other staging buffer
+    {
+        std::unique_lock lock{mutex_};
+        cv_.wait(lock, [this] { return !pending_ && !busy_; });
+        pending_ = job{staging.data(), staging_pitch_, pixels, pitch, dst_format};
+    }
+    cv_.notify_all();
+    return frame;
+}
@@ -0,0 +1,308 @@
+#include "sdl2pp/frame_sink.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "pixel_access.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SDL2PP_FRAME_SINK_SSE2 1
+#endif
+
+using namespace sdl2;
+
+namespace {
+
+// BT.601 limited range in 8-bit fixed point. Chroma coefficients stay below 2^15 / 255 so the SSE2
+// path can evaluate them in signed 16-bit lanes and match the scalar path exactly.
+constexpr int luma(int const r, int const g, int const b) noexcept {
+    return ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+}
+
+constexpr int chroma_u(int const r, int const g, int const b) noexcept {
+    return ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+}
+
+constexpr int chroma_v(int const r, int const g, int const b) noexcept {
+    return ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+}
+
+struct rgb_reader {
+    std::optional<detail::byte_layout> layout;
+    SDL_PixelFormat const* fmt;
+    int bpp;
+
+    void operator()(std::byte const* const p, int& r, int& g, int& b) const noexcept {
+        if (layout) {
+            r = std::to_integer<int>(p[layout->r]);
+            g = std::to_integer<int>(p[layout->g]);
+            b = std::to_integer<int>(p[layout->b]);
+        } else {
+            std::uint8_t r8, g8, b8;
+            SDL_GetRGB(detail::load_pixel(p, bpp), fmt, &r8, &g8, &b8);
+            r = r8;
+            g = g8;
+            b = b8;
+        }
+    }
+};
+
+// converts the pixel pair rows (row0, row1) from column x onwards, one 2x2 block at a time
+void convert_blocks(rgb_reader const& read, std::byte const* const row0, std::byte const* const row1, int x, int const width,
+                    std::byte* const y0, std::byte* const y1, std::byte* const u, std::byte* const v) noexcept {
+    auto const bpp = read.bpp;
+    for (; x < width; x += 2) {
+        auto const x1 = std::min(x + 1, width - 1);
+        int r[4], g[4], b[4];
+        read(row0 + x * bpp, r[0], g[0], b[0]);
+        read(row0 + x1 * bpp, r[1], g[1], b[1]);
+        read(row1 + x * bpp, r[2], g[2], b[2]);
+        read(row1 + x1 * bpp, r[3], g[3], b[3]);
+
+        y0[x] = static_cast<std::byte>(luma(r[0], g[0], b[0]));
+        if (x1 != x)
+            y0[x1] = static_cast<std::byte>(luma(r[1], g[1], b[1]));
+        if (y1) {
+            y1[x] = static_cast<std::byte>(luma(r[2], g[2], b[2]));
+            if (x1 != x)
+                y1[x1] = static_cast<std::byte>(luma(r[3], g[3], b[3]));
+        }
+
+        auto const ra = (r[0] + r[1] + r[2] + r[3] + 2) >> 2;
+        auto const ga = (g[0] + g[1] + g[2] + g[3] + 2) >> 2;
+        auto const ba = (b[0] + b[1] + b[2] + b[3] + 2) >> 2;
+        u[x / 2] = static_cast<std::byte>(chroma_u(ra, ga, ba));
+        v[x / 2] = static_cast<std::byte>(chroma_v(ra, ga, ba));
+    }
+}
+
+#ifdef SDL2PP_FRAME_SINK_SSE2
+// one channel of eight 4-byte pixels as 16-bit lanes
+inline __m128i channel(__m128i const lo, __m128i const hi, int const offset) noexcept {
+    auto const shift = _mm_cvtsi32_si128(offset * 8);
+    auto const mask = _mm_set1_epi32(0xFF);
+    return _mm_packs_epi32(_mm_and_si128(_mm_srl_epi32(lo, shift), mask), _mm_and_si128(_mm_srl_epi32(hi, shift), mask));
+}
+
+inline __m128i luma8(__m128i const r, __m128i const g, __m128i const b) noexcept {
+    // the weighted sum is below 2^16, so unsigned 16-bit lanes hold it exactly
+    auto sum = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(66)), _mm_mullo_epi16(g, _mm_set1_epi16(129)));
+    sum = _mm_add_epi16(sum, _mm_mullo_epi16(b, _mm_set1_epi16(25)));
+    sum = _mm_add_epi16(sum, _mm_set1_epi16(128));
+    return _mm_add_epi16(_mm_srli_epi16(sum, 8), _mm_set1_epi16(16));
+}
+
+inline __m128i chroma4(__m128i const r, __m128i const g, __m128i const b, short const cr, short const cg, short const cb) noexcept {
+    auto sum = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(cr)), _mm_mullo_epi16(g, _mm_set1_epi16(cg)));
+    sum = _mm_add_epi16(sum, _mm_mullo_epi16(b, _mm_set1_epi16(cb)));
+    sum = _mm_add_epi16(sum, _mm_set1_epi16(128));
+    return _mm_add_epi16(_mm_srai_epi16(sum, 8), _mm_set1_epi16(128));
+}
+
+// the rounded average of each 2x2 block, for four blocks spanning eight columns of two rows
+inline __m128i block_average(__m128i const c0, __m128i const c1) noexcept {
+    auto const pairs = _mm_add_epi32(_mm_madd_epi16(c0, _mm_set1_epi16(1)), _mm_madd_epi16(c1, _mm_set1_epi16(1)));
+    auto const avg = _mm_srli_epi32(_mm_add_epi32(pairs, _mm_set1_epi32(2)), 2);
+    return _mm_packs_epi32(avg, avg);
+}
+
+// converts eight columns of two rows of 4-byte pixels and returns the first column left over
+int convert_blocks_sse2(detail::byte_layout const& l, std::byte const* const row0, std::byte const* const row1, int const width,
+                        std::byte* const y0, std::byte* const y1, std::byte* const u, std::byte* const v) noexcept {
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        auto const p00 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(row0 + x * 4));
+        auto const p01 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(row0 + x * 4 + 16));
+        auto const p10 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(row1 + x * 4));
+        auto const p11 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(row1 + x * 4 + 16));
+
+        auto const r0 = channel(p00, p01, l.r), g0 = channel(p00, p01, l.g), b0 = channel(p00, p01, l.b);
+        auto const r1 = channel(p10, p11, l.r), g1 = channel(p10, p11, l.g), b1 = channel(p10, p11, l.b);
+
+        auto const l0 = luma8(r0, g0, b0);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(y0 + x), _mm_packus_epi16(l0, l0));
+        if (y1) {
+            auto const l1 = luma8(r1, g1, b1);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(y1 + x), _mm_packus_epi16(l1, l1));
+        }
+
+        auto const ra = block_average(r0, r1), ga = block_average(g0, g1), ba = block_average(b0, b1);
+        auto const cu = chroma4(ra, ga, ba, -38, -74, 112);
+        auto const cv = chroma4(ra, ga, ba, 112, -94, -18);
+        auto const uv = _mm_packus_epi16(cu, cv);
+        auto const uu = _mm_cvtsi128_si32(uv), vv = _mm_cvtsi128_si32(_mm_srli_si128(uv, 8));
+        std::memcpy(u + x / 2, &uu, 4);
+        std::memcpy(v + x / 2, &vv, 4);
+    }
+    return x;
+}
+#endif
+
+} // namespace
+
+bool sdl2::rgb_to_yuv420(surface const& s,
+                         std::span<std::byte> const yplane, int const ypitch,
+                         std::span<std::byte> const uplane, int const upitch,
+                         std::span<std::byte> const vplane, int const vpitch) noexcept {
+    auto const fmt = s.pixel_format();
+    auto const w = s.width(), h = s.height();
+    auto const cw = (w + 1) / 2, ch = (h + 1) / 2;
+    if (fmt.has_palette() || SDL_ISPIXELFORMAT_FOURCC(fmt.native_handle()->format) || fmt.bytes_per_pixel() == 0)
+        return false;
+    if (ypitch < w || upitch < cw || vpitch < cw
+        || yplane.size() < static_cast<std::size_t>(ypitch) * static_cast<std::size_t>(h)
+        || uplane.size() < static_cast<std::size_t>(upitch) * static_cast<std::size_t>(ch)
+        || vplane.size() < static_cast<std::size_t>(vpitch) * static_cast<std::size_t>(ch))
+        return false;
+
+    // locking does not change the pixels, so it is fine on a surface the caller lent as const
+    auto& src = const_cast<surface&>(s);
+    detail::surface_lock_guard const lock{src};
+    if (src.pixels() == nullptr)
+        return false;
+
+    rgb_reader const read{detail::get_byte_layout(fmt), fmt.native_handle(), fmt.bytes_per_pixel()};
+    for (int j = 0; j < ch; ++j) {
+        auto const r0 = 2 * j, r1 = std::min(2 * j + 1, h - 1);
+        auto const row0 = detail::pixel_at(s, 0, r0);
+        auto const row1 = detail::pixel_at(s, 0, r1);
+        auto* const y0 = yplane.data() + static_cast<std::ptrdiff_t>(r0) * ypitch;
+        auto* const y1 = r1 != r0 ? yplane.data() + static_cast<std::ptrdiff_t>(r1) * ypitch : nullptr;
+        auto* const u = uplane.data() + static_cast<std::ptrdiff_t>(j) * upitch;
+        auto* const v = vplane.data() + static_cast<std::ptrdiff_t>(j) * vpitch;
+
+        int x = 0;
+#ifdef SDL2PP_FRAME_SINK_SSE2
+        if (read.layout && read.bpp == 4)
+            x = convert_blocks_sse2(*read.layout, row0, row1, w, y0, y1, u, v);
+#endif
+        convert_blocks(read, row0, row1, x, w, y0, y1, u, v);
+    }
+    return true;
+}
+
+frame_sink::frame_sink(null_term_string const file, wh<int> const size, frame_sink_format const format, int const fps, std::size_t const queue_depth)
+    : file_{SDL_RWFromFile(file.data(), "wb")}
+    , size_{size}
+    , format_{format}
+{
+    auto const pixels = static_cast<std::size_t>(size.width) * static_cast<std::size_t>(size.height);
+    auto const chroma = static_cast<std::size_t>((size.width + 1) / 2) * static_cast<std::size_t>((size.height + 1) / 2);
+    frame_bytes_ = format == frame_sink_format::Y4M ? pixels + 2 * chroma : pixels * 4;
+
+    if (!file_)
+        return;
+    if (size.width <= 0 || size.height <= 0) {
+        SDL_RWclose(std::exchange(file_, nullptr));
+        return;
+    }
+
+    if (format == frame_sink_format::Y4M) {
+        // C420jpeg: chroma sited between the pixels of each 2x2 block, which is how they are averaged
+        char header[128];
+        auto const len = std::snprintf(header, sizeof(header), "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n", size.width, size.height, std::max(fps, 1));
+        if (SDL_RWwrite(file_, header, static_cast<std::size_t>(len), 1) != 1) {
+            SDL_RWclose(std::exchange(file_, nullptr));
+            return;
+        }
+    }
+
+    // Y4M buffers hold the per-frame "FRAME\n" marker ahead of the planes, so a frame is one write
+    buffers_.resize(std::max<std::size_t>(queue_depth, 1));
+    for (auto& b : buffers_)
+        b.resize(frame_bytes_ + (format == frame_sink_format::Y4M ? 6 : 0));
+    writer_ = std::thread{&frame_sink::run, this};
+}
+
+frame_sink::~frame_sink() noexcept {
+    if (writer_.joinable()) {
+        {
+            std::lock_guard lock{mutex_};
+            stop_ = true;
+        }
+        cv_.notify_all();
+        writer_.join();
+    }
+    if (file_)
+        SDL_RWclose(file_);
+}
+
+void frame_sink::run() noexcept {
+    std::unique_lock lock{mutex_};
+    for (;;) {
+        cv_.wait(lock, [this] { return stop_ || written_ < submitted_; });
+        if (written_ == submitted_)
+            return;
+
+        // frames are written in order, so the producer never touches this buffer until written_ moves on
+        auto const& buffer = buffers_[written_ % buffers_.size()];
+        auto const ok = !failed_;
+        lock.unlock();
+        auto const wrote = ok && SDL_RWwrite(file_, buffer.data(), buffer.size(), 1) == 1;
+        lock.lock();
+        failed_ = failed_ || !wrote;
+        ++written_;
+        cv_.notify_all();
+    }
+}
+
+bool frame_sink::convert(surface const& s, std::byte* dst) noexcept {
+    if (format_ == frame_sink_format::RAW_RGBA) {
+        auto& src = const_cast<surface&>(s);
+        detail::surface_lock_guard const lock{src};
+        return src.pixels() != nullptr
+            && SDL_ConvertPixels(size_.width, size_.height, s.pixel_format().native_handle()->format, s.pixels(), s.pitch(),
+                                 SDL_PIXELFORMAT_RGBA32, dst, size_.width * 4) == 0;
+    }
+
+    std::memcpy(dst, "FRAME\n", 6);
+    dst += 6;
+    auto const luma_bytes = static_cast<std::size_t>(size_.width) * static_cast<std::size_t>(size_.height);
+    auto const cw = (size_.width + 1) / 2;
+    auto const chroma_bytes = (frame_bytes_ - luma_bytes) / 2;
+    return rgb_to_yuv420(s,
+        {dst, luma_bytes}, size_.width,
+        {dst + luma_bytes, chroma_bytes}, cw,
+        {dst + luma_bytes + chroma_bytes, chroma_bytes}, cw);
+}
+
+bool frame_sink::write(surface const& s) noexcept {
+    if (!writer_.joinable() || s.width() != size_.width || s.height() != size_.height)
+        return false;
+
+    std::uint64_t frame;
+    {
+        std::unique_lock lock{mutex_};
+        cv_.wait(lock, [this] { return failed_ || submitted_ - written_ < buffers_.size(); });
+        if (failed_)
+            return false;
+        frame = submitted_;
+    }
+
+    // only this thread advances submitted_, so the buffer stays ours until it is published below
+    if (!convert(s, buffers_[frame % buffers_.size()].data()))
+        return false;
+    {
+        std::lock_guard lock{mutex_};
+        ++submitted_;
+    }
+    cv_.notify_all();
+    return true;
+}
+
+bool frame_sink::flush() noexcept {
+    std::unique_lock lock{mutex_};
+    cv_.wait(lock, [this] { return written_ == submitted_; });
+    return file_ && !failed_;
+}
+
+frame_sink::operator bool() const noexcept {
+    std::lock_guard lock{mutex_};
+    return writer_.joinable() && !failed_;
+}
+
+std::uint64_t frame_sink::frames_written() const noexcept {
+    std::lock_guard lock{mutex_};
+    return written_;
+}
@@ -0,0 +1,336 @@
+#include "sdl2pp/glyph_cache.hpp"
+#include "sdl2pp/renderer.hpp"
+
+#include <algorithm>
+#include <array>
+
+using namespace sdl2;
+
+namespace {
+
+// the public domain font8x8_basic set for U+0020 to U+007E; bit 0 of each row is the leftmost pixel
+constexpr std::uint8_t font8x8[95][8] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // ' '
+    {0x18, 0x3C, 0x3C, 0x18, 0x18, 0x00, 0x18, 0x00}, // !
+    {0x36, 0x36, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // "
+    {0x36, 0x36, 0x7F, 0x36, 0x7F, 0x36, 0x36, 0x00}, // #
+    {0x0C, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x0C, 0x00}, // $
+    {0x00, 0x63, 0x33, 0x18, 0x0C, 0x66, 0x63, 0x00}, // %
+    {0x1C, 0x36, 0x1C, 0x6E, 0x3B, 0x33, 0x6E, 0x00}, // &
+    {0x06, 0x06, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00}, // '
+    {0x18, 0x0C, 0x06, 0x06, 0x06, 0x0C, 0x18, 0x00}, // (
+    {0x06, 0x0C, 0x18, 0x18, 0x18, 0x0C, 0x06, 0x00}, // )
+    {0x00, 0x66, 0x3C, 0xFF, 0x3C, 0x66, 0x00, 0x00}, // *
+    {0x00, 0x0C, 0x0C, 0x3F, 0x0C, 0x0C, 0x00, 0x00}, // +
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x06}, // ,
+    {0x00, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x00}, // -
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x00}, // .
+    {0x60, 0x30, 0x18, 0x0C, 0x06, 0x03, 0x01, 0x00}, // /
+    {0x3E, 0x63, 0x73, 0x7B, 0x6F, 0x67, 0x3E, 0x00}, // 0
+    {0x0C, 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x3F, 0x00}, // 1
+    {0x1E, 0x33, 0x30, 0x1C, 0x06, 0x33, 0x3F, 0x00}, // 2
+    {0x1E, 0x33, 0x30, 0x1C, 0x30, 0x33, 0x1E, 0x00}, // 3
+    {0x38, 0x3C, 0x36, 0x33, 0x7F, 0x30, 0x78, 0x00}, // 4
+    {0x3F, 0x03, 0x1F, 0x30, 0x30, 0x33, 0x1E, 0x00}, // 5
+    {0x1C, 0x06, 0x03, 0x1F, 0x33, 0x33, 0x1E, 0x00}, // 6
+    {0x3F, 0x33, 0x30, 0x18, 0x0C, 0x0C, 0x0C, 0x00}, // 7
+    {0x1E, 0x33, 0x33, 0x1E, 0x33, 0x33, 0x1E, 0x00}, // 8
+    {0x1E, 0x33, 0x33, 0x3E, 0x30, 0x18, 0x0E, 0x00}, // 9
+    {0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x00}, // :
+    {0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x06}, // ;
+    {0x18, 0x0C, 0x06, 0x03, 0x06, 0x0C, 0x18, 0x00}, // <
+    {0x00, 0x00, 0x3F, 0x00, 0x00, 0x3F, 0x00, 0x00}, // =
+    {0x06, 0x0C, 0x18, 0x30, 0x18, 0x0C, 0x06, 0x00}, // >
+    {0x1E, 0x33, 0x30, 0x18, 0x0C, 0x00, 0x0C, 0x00}, // ?
+    {0x3E, 0x63, 0x7B, 0x7B, 0x7B, 0x03, 0x1E, 0x00}, // @
+    {0x0C, 0x1E, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x00}, // A
+    {0x3F, 0x66, 0x66, 0x3E, 0x66, 0x66, 0x3F, 0x00}, // B
+    {0x3C, 0x66, 0x03, 0x03, 0x03, 0x66, 0x3C, 0x00}, // C
+    {0x1F, 0x36, 0x66, 0x66, 0x66, 0x36, 0x1F, 0x00}, // D
+    {0x7F, 0x46, 0x16, 0x1E, 0x16, 0x46, 0x7F, 0x00}, // E
+    {0x7F, 0x46, 0x16, 0x1E, 0x16, 0x06, 0x0F, 0x00}, // F
+    {0x3C, 0x66, 0x03, 0x03, 0x73, 0x66, 0x7C, 0x00}, // G
+    {0x33, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x33, 0x00}, // H
+    {0x1E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, // I
+    {0x78, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E, 0x00}, // J
+    {0x67, 0x66, 0x36, 0x1E, 0x36, 0x66, 0x67, 0x00}, // K
+    {0x0F, 0x06, 0x06, 0x06, 0x46, 0x66, 0x7F, 0x00}, // L
+    {0x63, 0x77, 0x7F, 0x7F, 0x6B, 0x63, 0x63, 0x00}, // M
+    {0x63, 0x67, 0x6F, 0x7B, 0x73, 0x63, 0x63, 0x00}, // N
+    {0x1C, 0x36, 0x63, 0x63, 0x63, 0x36, 0x1C, 0x00}, // O
+    {0x3F, 0x66, 0x66, 0x3E, 0x06, 0x06, 0x0F, 0x00}, // P
+    {0x1E, 0x33, 0x33, 0x33, 0x3B, 0x1E, 0x38, 0x00}, // Q
+    {0x3F, 0x66, 0x66, 0x3E, 0x36, 0x66, 0x67, 0x00}, // R
+    {0x1E, 0x33, 0x07, 0x0E, 0x38, 0x33, 0x1E, 0x00}, // S
+    {0x3F, 0x2D, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, // T
+    {0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x3F, 0x00}, // U
+    {0x33, 0x33, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00}, // V
+    {0x63, 0x63, 0x63, 0x6B, 0x7F, 0x77, 0x63, 0x00}, // W
+    {0x63, 0x63, 0x36, 0x1C, 0x1C, 0x36, 0x63, 0x00}, // X
+    {0x33, 0x33, 0x33, 0x1E, 0x0C, 0x0C, 0x1E, 0x00}, // Y
+    {0x7F, 0x63, 0x31, 0x18, 0x4C, 0x66, 0x7F, 0x00}, // Z
+    {0x1E, 0x06, 0x06, 0x06, 0x06, 0x06, 0x1E, 0x00}, // [
+    {0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x40, 0x00}, // backslash
+    {0x1E, 0x18, 0x18, 0x18, 0x18, 0x18, 0x1E, 0x00}, // ]
+    {0x08, 0x1C, 0x36, 0x63, 0x00, 0x00, 0x00, 0x00}, // ^
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF}, // _
+    {0x0C, 0x0C, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00}, // `
+    {0x00, 0x00, 0x1E, 0x30, 0x3E, 0x33, 0x6E, 0x00}, // a
+    {0x07, 0x06, 0x06, 0x3E, 0x66, 0x66, 0x3B, 0x00}, // b
+    {0x00, 0x00, 0x1E, 0x33, 0x03, 0x33, 0x1E, 0x00}, // c
+    {0x38, 0x30, 0x30, 0x3E, 0x33, 0x33, 0x6E, 0x00}, // d
+    {0x00, 0x00, 0x1E, 0x33, 0x3F, 0x03, 0x1E, 0x00}, // e
+    {0x1C, 0x36, 0x06, 0x0F, 0x06, 0x06, 0x0F, 0x00}, // f
+    {0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x1F}, // g
+    {0x07, 0x06, 0x36, 0x6E, 0x66, 0x66, 0x67, 0x00}, // h
+    {0x0C, 0x00, 0x0E, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, // i
+    {0x30, 0x00, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E}, // j
+    {0x07, 0x06, 0x66, 0x36, 0x1E, 0x36, 0x67, 0x00}, // k
+    {0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, // l
+    {0x00, 0x00, 0x33, 0x7F, 0x7F, 0x6B, 0x63, 0x00}, // m
+    {0x00, 0x00, 0x1F, 0x33, 0x33, 0x33, 0x33, 0x00}, // n
+    {0x00, 0x00, 0x1E, 0x33, 0x33, 0x33, 0x1E, 0x00}, // o
+    {0x00, 0x00, 0x3B, 0x66, 0x66, 0x3E, 0x06, 0x0F}, // p
+    {0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x78}, // q
+    {0x00, 0x00, 0x3B, 0x6E, 0x66, 0x06, 0x0F, 0x00}, // r
+    {0x00, 0x00, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x00}, // s
+    {0x08, 0x0C, 0x3E, 0x0C, 0x0C, 0x2C, 0x18, 0x00}, // t
+    {0x00, 0x00, 0x33, 0x33, 0x33, 0x33, 0x6E, 0x00}, // u
+    {0x00, 0x00, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00}, // v
+    {0x00, 0x00, 0x63, 0x6B, 0x7F, 0x7F, 0x36, 0x00}, // w
+    {0x00, 0x00, 0x63, 0x36, 0x1C, 0x36, 0x63, 0x00}, // x
+    {0x00, 0x00, 0x33, 0x33, 0x33, 0x3E, 0x30, 0x1F}, // y
+    {0x00, 0x00, 0x3F, 0x19, 0x0C, 0x26, 0x3F, 0x00}, // z
+    {0x38, 0x0C, 0x0C, 0x07, 0x0C, 0x0C, 0x38, 0x00}, // {
+    {0x18, 0x18, 0x18, 0x00, 0x18, 0x18, 0x18, 0x00}, // |
+    {0x07, 0x0C, 0x0C, 0x38, 0x0C, 0x0C, 0x07, 0x00}, // }
+    {0x6E, 0x3B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // ~
+};
+
+constexpr char32_t replacement = U'\uFFFD';
+
+// decodes one code point and advances i past it; malformed sequences decode to U+FFFD one byte at a time
+char32_t decode_utf8(std::string_view const s, std::size_t& i) noexcept {
+    auto const lead = static_cast<unsigned char>(s[i++]);
+    if (lead < 0x80)
+        return lead;
+
+    int const extra = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : 0;
+    if (extra == 0 || lead > 0xF4 || i + extra > s.size())
+        return replacement;
+
+    char32_t cp = lead & (0x3F >> extra);
+    for (int k = 0; k < extra; ++k) {
+        auto const c = static_cast<unsigned char>(s[i + k]);
+        if ((c & 0xC0) != 0x80)
+            return replacement;
+        cp = (cp << 6) | (c & 0x3F);
+    }
+    constexpr char32_t min_by_length[] = {0, 0x80, 0x800, 0x10000};
+    if (cp < min_by_length[extra] || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+        return replacement;
+    i += extra;
+    return cp;
+}
+
+// transparent white, so linear filtering across a glyph's edge fades its alpha without darkening it
+constexpr auto transparent_texels = [] {
+    std::array<std::uint32_t, 16384> texels{};
+    texels.fill(0x00FFFFFFu);
+    return texels;
+}();
+
+// a STATIC texture starts with undefined contents; filling it keeps the padding around glyphs transparent
+void clear_atlas(texture& atlas, wh<int> const size) noexcept {
+    auto const piece_w = std::min(size.width, static_cast<int>(transparent_texels.size()));
+    auto const piece_h = static_cast<int>(transparent_texels.size()) / std::max(piece_w, 1);
+    for (int y = 0; y < size.height; y += piece_h) {
+        for (int x = 0; x < size.width; x += piece_w) {
+            rect<int> const area{x, y, std::min(piece_w, size.width - x), std::min(piece_h, size.height - y)};
+            atlas.update(area, std::as_bytes(std::span{transparent_texels}), piece_w * 4);
+        }
+    }
+}
+
+} // namespace
+
+bitmap_font::bitmap_font(int const scale) noexcept
+    : scale_{std::max(scale, 1)} {}
+
+int bitmap_font::ascent() const noexcept { return 7 * scale_; }
+
+// one blank row between lines so descenders do not touch the caps below
+int bitmap_font::line_height() const noexcept { return 9 * scale_; }
+
+std::optional<glyph_metrics> bitmap_font::metrics(char32_t const cp) const noexcept {
+    if (cp < 0x20 || cp > 0x7E)
+        return {};
+    return glyph_metrics{{8 * scale_, 8 * scale_}, {0, -7 * scale_}, 8 * scale_};
+}
+
+bool bitmap_font::rasterize(char32_t const cp, std::span<std::uint8_t> const coverage, int const pitch) const noexcept {
+    auto const size = 8 * scale_;
+    if (cp < 0x20 || cp > 0x7E || pitch < size || coverage.size() < static_cast<std::size_t>(pitch) * static_cast<std::size_t>(size - 1) + static_cast<std::size_t>(size))
+        return false;
+
+    auto const& rows = font8x8[cp - 0x20];
+    for (int y = 0; y < size; ++y) {
+        auto const bits = rows[y / scale_];
+        auto* const out = coverage.data() + static_cast<std::ptrdiff_t>(y) * pitch;
+        for (int x = 0; x < size; ++x)
+            out[x] = ((bits >> (x / scale_)) & 1) ? 255 : 0;
+    }
+    return true;
+}
+
+glyph_cache::glyph_cache(renderer& r, glyph_rasterizer const& rasterizer, wh<int> const atlas_size)
+    : renderer_{r}
+    , rasterizer_{rasterizer}
+    , atlas_{r, pixel_format_enum::ARGB8888, texture_access::STATIC, atlas_size}
+    , atlas_size_{atlas_size}
+{
+    if (atlas_) {
+        atlas_.set_blend_mode(blend_mode::BLEND);
+        clear_atlas(atlas_, atlas_size_);
+    }
+}
+
+void glyph_cache::clear() noexcept {
+    glyphs_.clear();
+    shelf_x_ = shelf_y_ = shelf_h_ = 0;
+    ++generation_;
+    if (atlas_)
+        clear_atlas(atlas_, atlas_size_);
+}
+
+glyph_cache::glyph const* glyph_cache::insert(char32_t const cp, glyph_metrics const& m) {
+    // one pixel of padding keeps linear filtering from sampling a neighbour
+    auto const w = m.size.width + 1, h = m.size.height + 1;
+    if (w > atlas_size_.width || h > atlas_size_.height)
+        return nullptr;
+    if (shelf_x_ + w > atlas_size_.width) {
+        shelf_y_ += shelf_h_;
+        shelf_x_ = shelf_h_ = 0;
+    }
+    if (shelf_y_ + h > atlas_size_.height) {
+        clear();
+    }
+
+    rect<int> const src{shelf_x_, shelf_y_, m.size.width, m.size.height};
+    if (!src.empty()) {
+        auto const count = static_cast<std::size_t>(m.size.width) * static_cast<std::size_t>(m.size.height);
+        coverage_.assign(count, 0);
+        if (!rasterizer_.rasterize(cp, coverage_, m.size.width))
+            return nullptr;
+        upload_.resize(count);
+        std::transform(coverage_.begin(), coverage_.end(), upload_.begin(), [](std::uint8_t const a) {
+            return (static_cast<std::uint32_t>(a) << 24) | 0x00FFFFFFu;
+        });
+        if (!atlas_.update(src, std::as_bytes(std::span{upload_}), m.size.width * 4))
+            return nullptr;
+    }
+
+    shelf_x_ += w;
+    shelf_h_ = std::max(shelf_h_, h);
+    return &glyphs_.insert_or_assign(cp, glyph{src, m}).first->second;
+}
+
+glyph_cache::glyph const* glyph_cache::find(char32_t const cp) {
+    if (auto const it = glyphs_.find(cp); it != glyphs_.end())
+        return &it->second;
+    if (auto const m = rasterizer_.metrics(cp))
+        return insert(cp, *m);
+    if (cp != U'?')
+        return find(U'?');
+    return nullptr;
+}
+
+void glyph_cache::preload(std::string_view const utf8) {
+    for (std::size_t i = 0; i < utf8.size();)
+        find(decode_utf8(utf8, i));
+}
+
+wh<int> glyph_cache::measure(std::string_view const utf8) {
+    int width = 0, line = 0, lines = 1;
+    char32_t prev = 0;
+    for (std::size_t i = 0; i < utf8.size();) {
+        auto const cp = decode_utf8(utf8, i);
+        if (cp == U'\n') {
+            width = std::max(width, line);
+            line = 0;
+            prev = 0;
+            ++lines;
+            continue;
+        }
+        if (auto const* const g = find(cp)) {
+            line += (prev ? rasterizer_.kerning(prev, cp) : 0) + g->metrics.advance;
+            prev = cp;
+        }
+    }
+    return {std::max(width, line), lines * rasterizer_.line_height()};
+}
+
+void glyph_cache::build(std::string_view const utf8, point<float> const pos, SDL_Color const color) {
+    vertices_.clear();
+    indices_.clear();
+
+    auto const u = 1.0f / static_cast<float>(atlas_size_.width);
+    auto const v = 1.0f / static_cast<float>(atlas_size_.height);
+    auto pen_x = pos.x();
+    auto baseline = pos.y() + static_cast<float>(rasterizer_.ascent());
+    char32_t prev = 0;
+    for (std::size_t i = 0; i < utf8.size();) {
+        auto const cp = decode_utf8(utf8, i);
+        if (cp == U'\n') {
+            pen_x = pos.x();
+            baseline += static_cast<float>(rasterizer_.line_height());
+            prev = 0;
+            continue;
+        }
+
+        auto const* const g = find(cp);
+        if (!g)
+            continue;
+        if (prev)
+            pen_x += static_cast<float>(rasterizer_.kerning(prev, cp));
+        prev = cp;
+
+        if (!g->src.empty()) {
+            auto const x0 = pen_x + static_cast<float>(g->metrics.bearing.x());
+            auto const y0 = baseline + static_cast<float>(g->metrics.bearing.y());
+            auto const x1 = x0 + static_cast<float>(g->src.w());
+            auto const y1 = y0 + static_cast<float>(g->src.h());
+            auto const s0 = static_cast<float>(g->src.x()) * u, s1 = static_cast<float>(g->src.x() + g->src.w()) * u;
+            auto const t0 = static_cast<float>(g->src.y()) * v, t1 = static_cast<float>(g->src.y() + g->src.h()) * v;
+
+            auto const base = static_cast<int>(vertices_.size());
+            vertices_.push_back({{x0, y0}, color, {s0, t0}});
+            vertices_.push_back({{x1, y0}, color, {s1, t0}});
+            vertices_.push_back({{x1, y1}, color, {s1, t1}});
+            vertices_.push_back({{x0, y1}, color, {s0, t1}});
+            for (auto const k : {0, 1, 2, 0, 2, 3})
+                indices_.push_back(base + k);
+        }
+        pen_x += static_cast<float>(g->metrics.advance);
+    }
+}
+
+bool glyph_cache::draw_text(std::string_view const utf8, point<float> const pos, rgba<> const color) {
+    if (!atlas_)
+        return false;
+
+    SDL_Color const c{color.r, color.g, color.b, color.a};
+    auto const generation = generation_;
+    build(utf8, pos, c);
+    if (generation_ != generation) {
+        // the atlas was emptied part way through, invalidating the quads built before that point;
+        // every glyph of the string is now cached, so a second pass only fails if they cannot fit together
+        auto const refilled = generation_;
+        build(utf8, pos, c);
+        if (generation_ != refilled)
+            return false;
+    }
+    if (indices_.empty())
+        return true;
+    return renderer_.render_geometry(atlas_, vertices_, indices_);
+}
@@ -0,0 +1,163 @@
+#include "sdl2pp/histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "parallel.hpp"
+#include "pixel_access.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SDL2PP_HISTOGRAM_SSE2 1
+#endif
+
+using namespace sdl2;
+
+namespace {
+
+constexpr int luma_r = 77, luma_g = 150, luma_b = 29;
+
+using channel_bins = std::array<std::array<std::uint64_t, 256>, 5>;
+
+// Writes the luma of a row of pixels. The SSE2 loop weighs four 4-byte pixels per step with
+// _mm_madd_epi16 and rounds exactly like the scalar tail.
+void luma_row(std::uint8_t const* const p, detail::byte_layout const& l, int const width, std::uint8_t* const out) noexcept {
+    int x = 0;
+#ifdef SDL2PP_HISTOGRAM_SSE2
+    if (l.bytes == 4) {
+        std::array<short, 4> w{};
+        w[static_cast<std::size_t>(l.r)] = luma_r;
+        w[static_cast<std::size_t>(l.g)] = luma_g;
+        w[static_cast<std::size_t>(l.b)] = luma_b;
+        auto const weights = _mm_setr_epi16(w[0], w[1], w[2], w[3], w[0], w[1], w[2], w[3]);
+        auto const zero = _mm_setzero_si128(), half = _mm_set1_epi32(128);
+        for (; x + 4 <= width; x += 4) {
+            auto const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + 4 * x));
+            // pairs of channel products per pixel: {p0, p0, p1, p1} and {p2, p2, p3, p3}
+            auto const lo = _mm_castsi128_ps(_mm_madd_epi16(_mm_unpacklo_epi8(v, zero), weights));
+            auto const hi = _mm_castsi128_ps(_mm_madd_epi16(_mm_unpackhi_epi8(v, zero), weights));
+            auto const even = _mm_castps_si128(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)));
+            auto const odd = _mm_castps_si128(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1)));
+            auto const y = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(even, odd), half), 8);
+            auto const bytes = _mm_packus_epi16(_mm_packs_epi32(y, y), zero);
+            auto const four = static_cast<std::uint32_t>(_mm_cvtsi128_si32(bytes));
+            std::memcpy(out + x, &four, 4);
+        }
+    }
+#endif
+    for (; x < width; ++x) {
+        auto const* const s = p + l.bytes * x;
+        out[x] = static_cast<std::uint8_t>((luma_r * s[l.r] + luma_g * s[l.g] + luma_b * s[l.b] + 128) >> 8);
+    }
+}
+
+// Counts a band of rows. Alternate pixels go to two sets of bins so that runs of one color, common in
+// rendered frames, do not stall on incrementing the same counter back to back.
+channel_bins count_rows(surface const& s, detail::byte_layout const& l, rect<int> const& area, int const begin, int const end) {
+    std::vector<channel_bins> bins(2);
+    std::vector<std::uint8_t> luma(static_cast<std::size_t>(area.w()));
+    auto const add = [&l](channel_bins& b, std::uint8_t const* const px, std::uint8_t const y) noexcept {
+        ++b[0][px[l.r]];
+        ++b[1][px[l.g]];
+        ++b[2][px[l.b]];
+        if (l.a >= 0)
+            ++b[3][px[l.a]];
+        ++b[4][y];
+    };
+    for (int y = area.y() + begin; y < area.y() + end; ++y) {
+        auto const* const p = reinterpret_cast<std::uint8_t const*>(detail::pixel_at(s, area.x(), y));
+        luma_row(p, l, area.w(), luma.data());
+        int x = 0;
+        for (; x + 2 <= area.w(); x += 2) {
+            add(bins[0], p + l.bytes * x, luma[static_cast<std::size_t>(x)]);
+            add(bins[1], p + l.bytes * (x + 1), luma[static_cast<std::size_t>(x) + 1]);
+        }
+        if (x < area.w())
+            add(bins[0], p + l.bytes * x, luma[static_cast<std::size_t>(x)]);
+    }
+    if (l.a < 0)
+        bins[0][3][255] = static_cast<std::uint64_t>(area.w()) * static_cast<std::uint64_t>(end - begin);
+
+    for (std::size_t c = 0; c < bins[0].size(); ++c) {
+        for (std::size_t i = 0; i < 256; ++i)
+            bins[0][c][i] += bins[1][c][i];
+    }
+    return bins[0];
+}
+
+channel_statistics statistics_of(std::array<std::uint64_t, 256> const& bins, std::size_t const pixels) noexcept {
+    channel_statistics st;
+    auto const first = std::find_if(bins.begin(), bins.end(), [](std::uint64_t const n) { return n != 0; });
+    if (first == bins.end())
+        return st;
+    auto const last = std::find_if(bins.rbegin(), bins.rend(), [](std::uint64_t const n) { return n != 0; });
+    st.min = static_cast<std::uint8_t>(first - bins.begin());
+    st.max = static_cast<std::uint8_t>(255 - (last - bins.rbegin()));
+
+    std::uint64_t sum = 0, squares = 0;
+    for (std::uint64_t i = 0; i < 256; ++i) {
+        sum += i * bins[i];
+        squares += i * i * bins[i];
+    }
+    auto const n = static_cast<double>(pixels);
+    st.mean = static_cast<double>(sum) / n;
+    st.variance = std::max(0.0, static_cast<double>(squares) / n - st.mean * st.mean);
+    return st;
+}
+
+} // namespace
+
+std::uint8_t surface_histogram::percentile(histogram_channel const c, double const fraction) const noexcept {
+    if (pixels == 0)
+        return 0;
+    auto const target = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(std::clamp(fraction, 0.0, 1.0) * static_cast<double>(pixels))));
+    std::uint64_t seen = 0;
+    auto const& b = (*this)[c];
+    for (std::size_t i = 0; i < b.size(); ++i) {
+        seen += b[i];
+        if (seen >= target)
+            return static_cast<std::uint8_t>(i);
+    }
+    return 255;
+}
+
+std::optional<surface_histogram> sdl2::compute_histogram(surface const& s, std::optional<rect<int>> const area, std::size_t const threads) {
+    if (!s)
+        return {};
+    auto const clipped = area ? area->intersection({0, 0, s.width(), s.height()}) : std::optional{rect<int>{0, 0, s.width(), s.height()}};
+    if (!clipped || clipped->empty())
+        return {};
+
+    std::optional<surface> converted;
+    auto const* src = &s;
+    auto layout = detail::get_byte_layout(s.pixel_format());
+    if (!layout) {
+        converted.emplace(s.convert_to_new(sdl2::pixel_format{pixel_format_enum::ARGB8888}));
+        if (!*converted)
+            return {};
+        src = &*converted;
+        layout = detail::get_byte_layout(src->pixel_format());
+        if (!layout)
+            return {};
+    }
+
+    detail::surface_lock_guard const lock{const_cast<surface&>(*src)};
+    if (src->pixels() == nullptr)
+        return {};
+
+    surface_histogram result;
+    result.pixels = static_cast<std::size_t>(clipped->w()) * static_cast<std::size_t>(clipped->h());
+    for (auto const& band : detail::parallel_rows(clipped->h(), static_cast<std::size_t>(clipped->w()), threads, [&](int const begin, int const end) {
+             return count_rows(*src, *layout, *clipped, begin, end);
+         })) {
+        for (std::size_t c = 0; c < band.size(); ++c) {
+            for (std::size_t i = 0; i < 256; ++i)
+                result.bins[c][i] += band[c][i];
+        }
+    }
+    for (std::size_t c = 0; c < result.bins.size(); ++c)
+        result.stats[c] = statistics_of(result.bins[c], result.pixels);
+    return result;
+}
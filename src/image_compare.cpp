@@ -0,0 +1,277 @@
+#include "sdl2pp/image_compare.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "parallel.hpp"
+#include "pixel_access.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SDL2PP_COMPARE_SSE2 1
+#endif
+
+using namespace sdl2;
+
+namespace {
+
+struct totals {
+    std::uint64_t sad = 0;
+    std::uint64_t sse = 0;
+    std::uint64_t differing = 0;
+    int max = 0;
+
+    void add(totals const& t) noexcept {
+        sad += t.sad;
+        sse += t.sse;
+        differing += t.differing;
+        max = std::max(max, t.max);
+    }
+};
+
+struct ssim_totals {
+    double sum = 0.0;
+    std::size_t windows = 0;
+};
+
+struct image_view {
+    surface const* s = nullptr;
+    detail::byte_layout l;
+};
+
+struct outputs {
+    surface* mask = nullptr;
+    surface* heatmap = nullptr;
+    detail::byte_layout l;
+};
+
+// compares one row channel by channel, for any pair of layouts, writing the mask and heatmap if wanted
+totals compare_row(image_view const& a, image_view const& b, int const y, bool const alpha, outputs const& out) noexcept {
+    totals t;
+    auto const* const pa = detail::row_at(*a.s, y);
+    auto const* const pb = detail::row_at(*b.s, y);
+    auto* const mask = out.mask ? detail::row_at(*out.mask, y) : nullptr;
+    auto* const heat = out.heatmap ? detail::row_at(*out.heatmap, y) : nullptr;
+    for (int x = 0; x < a.s->width(); ++x) {
+        auto const* const sa = pa + a.l.bytes * x;
+        auto const* const sb = pb + b.l.bytes * x;
+        std::array const diffs{std::abs(sa[a.l.r] - sb[b.l.r]), std::abs(sa[a.l.g] - sb[b.l.g]), std::abs(sa[a.l.b] - sb[b.l.b]),
+                               alpha ? std::abs(sa[a.l.a] - sb[b.l.a]) : 0};
+        int worst = 0;
+        for (auto const d : diffs) {
+            t.sad += static_cast<std::uint64_t>(d);
+            t.sse += static_cast<std::uint64_t>(d * d);
+            worst = std::max(worst, d);
+        }
+        t.max = std::max(t.max, worst);
+        t.differing += worst != 0 ? 1 : 0;
+
+        if (mask) {
+            auto const v = static_cast<std::uint8_t>(worst != 0 ? 0xFF : 0);
+            std::fill_n(mask + 4 * x, 4, v);
+        }
+        if (heat) {
+            auto* const h = heat + 4 * x;
+            auto const e = 3 * worst;
+            h[out.l.r] = static_cast<std::uint8_t>(std::min(e, 255));
+            h[out.l.g] = static_cast<std::uint8_t>(std::clamp(e - 255, 0, 255));
+            h[out.l.b] = static_cast<std::uint8_t>(std::clamp(e - 510, 0, 255));
+            h[out.l.a] = 0xFF;
+        }
+    }
+    return t;
+}
+
+// Compares one row of two surfaces with the same 4-byte layout. keep has 0xFF in the bytes that are
+// compared. The SSE2 loop and the scalar tail both sum exact integers, so they agree to the bit.
+totals compare_row_same(std::uint8_t const* const pa, std::uint8_t const* const pb, int const width, std::uint32_t const keep) noexcept {
+    totals t;
+    int x = 0;
+#ifdef SDL2PP_COMPARE_SSE2
+    auto const zero = _mm_setzero_si128(), k = _mm_set1_epi32(static_cast<int>(keep));
+    auto sad = zero, max = zero, sse = zero;
+    // each step adds at most 2 * 2 * 255^2 to a 32-bit lane of sse, so it is drained well before it overflows
+    constexpr int drain_every = 2048;
+    auto const drain = [&t](__m128i& v) {
+        alignas(16) std::uint32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), v);
+        t.sse += std::uint64_t{lanes[0]} + lanes[1] + lanes[2] + lanes[3];
+        v = _mm_setzero_si128();
+    };
+    for (int pending = 0; x + 4 <= width; x += 4) {
+        auto const va = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<__m128i const*>(pa + 4 * x)), k);
+        auto const vb = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<__m128i const*>(pb + 4 * x)), k);
+        auto const ad = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+        sad = _mm_add_epi64(sad, _mm_sad_epu8(ad, zero));
+        max = _mm_max_epu8(max, ad);
+        auto const lo = _mm_unpacklo_epi8(ad, zero), hi = _mm_unpackhi_epi8(ad, zero);
+        sse = _mm_add_epi32(sse, _mm_add_epi32(_mm_madd_epi16(lo, lo), _mm_madd_epi16(hi, hi)));
+        auto const same = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(va, vb)));
+        t.differing += static_cast<std::uint64_t>(4 - std::popcount(static_cast<unsigned>(same)));
+        if (++pending == drain_every) {
+            drain(sse);
+            pending = 0;
+        }
+    }
+    drain(sse);
+    alignas(16) std::uint64_t sads[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(sads), sad);
+    t.sad += sads[0] + sads[1];
+    alignas(16) std::uint8_t maxes[16];
+    _mm_store_si128(reinterpret_cast<__m128i*>(maxes), max);
+    t.max = *std::max_element(std::begin(maxes), std::end(maxes));
+#endif
+    for (; x < width; ++x) {
+        int worst = 0;
+        for (int c = 0; c < 4; ++c) {
+            if (((keep >> (8 * c)) & 0xFF) == 0)
+                continue;
+            auto const d = std::abs(pa[4 * x + c] - pb[4 * x + c]);
+            t.sad += static_cast<std::uint64_t>(d);
+            t.sse += static_cast<std::uint64_t>(d * d);
+            worst = std::max(worst, d);
+        }
+        t.max = std::max(t.max, worst);
+        t.differing += worst != 0 ? 1 : 0;
+    }
+    return t;
+}
+
+void luma_rows(image_view const& v, float* const out, int const begin, int const end) noexcept {
+    auto const w = v.s->width();
+    for (int y = begin; y < end; ++y) {
+        auto const* const p = detail::row_at(*v.s, y);
+        auto* const o = out + static_cast<std::size_t>(y) * static_cast<std::size_t>(w);
+        for (int x = 0; x < w; ++x) {
+            auto const* const s = p + v.l.bytes * x;
+            o[x] = 0.299f * s[v.l.r] + 0.587f * s[v.l.g] + 0.114f * s[v.l.b];
+        }
+    }
+}
+
+// SSIM of the windows whose top rows are the multiples of step in [begin, end)
+ssim_totals ssim_rows(float const* const la, float const* const lb, wh<int> const size, int const window, int const step, int const begin, int const end) noexcept {
+    constexpr double c1 = (0.01 * 255) * (0.01 * 255), c2 = (0.03 * 255) * (0.03 * 255);
+    auto const n = static_cast<double>(window) * window;
+    ssim_totals t;
+    for (int y0 = (begin + step - 1) / step * step; y0 < end && y0 + window <= size.height; y0 += step) {
+        for (int x0 = 0; x0 + window <= size.width; x0 += step) {
+            float sa = 0, sb = 0, saa = 0, sbb = 0, sab = 0;
+            for (int y = y0; y < y0 + window; ++y) {
+                auto const* __restrict const ra = la + static_cast<std::size_t>(y) * static_cast<std::size_t>(size.width) + x0;
+                auto const* __restrict const rb = lb + static_cast<std::size_t>(y) * static_cast<std::size_t>(size.width) + x0;
+                for (int x = 0; x < window; ++x) {
+                    sa += ra[x];
+                    sb += rb[x];
+                    saa += ra[x] * ra[x];
+                    sbb += rb[x] * rb[x];
+                    sab += ra[x] * rb[x];
+                }
+            }
+            auto const ma = sa / n, mb = sb / n;
+            auto const va = saa / n - ma * ma, vb = sbb / n - mb * mb, cov = sab / n - ma * mb;
+            t.sum += ((2 * ma * mb + c1) * (2 * cov + c2)) / ((ma * ma + mb * mb + c1) * (va + vb + c2));
+            ++t.windows;
+        }
+    }
+    return t;
+}
+
+} // namespace
+
+std::optional<image_difference> sdl2::compare_images(surface const& a, surface const& b, compare_options const& options) {
+    if (!a || !b || a.width() != b.width() || a.height() != b.height() || a.width() <= 0 || a.height() <= 0)
+        return {};
+
+    // formats whose channels are whole bytes are read in place, anything else goes through ARGB8888
+    std::optional<surface> converted_a, converted_b;
+    auto const view = [](surface const& s, std::optional<surface>& converted) -> std::optional<image_view> {
+        if (auto const l = detail::get_byte_layout(s.pixel_format()))
+            return image_view{&s, *l};
+        converted.emplace(s.convert_to_new(sdl2::pixel_format{pixel_format_enum::ARGB8888}));
+        if (auto const l = *converted ? detail::get_byte_layout(converted->pixel_format()) : std::nullopt)
+            return image_view{&*converted, *l};
+        return {};
+    };
+    auto const va = view(a, converted_a), vb = view(b, converted_b);
+    if (!va || !vb)
+        return {};
+
+    image_difference result;
+    auto const size = wh<int>{a.width(), a.height()};
+    if (options.mask)
+        result.mask.emplace(pixel_format_enum::RGBA32, 32, size);
+    if (options.heatmap)
+        result.heatmap.emplace(pixel_format_enum::RGBA32, 32, size);
+    if ((result.mask && !*result.mask) || (result.heatmap && !*result.heatmap))
+        return {};
+
+    detail::surface_lock_guard const lock_a{const_cast<surface&>(*va->s)};
+    detail::surface_lock_guard const lock_b{const_cast<surface&>(*vb->s)};
+    std::optional<detail::surface_lock_guard> lock_mask, lock_heatmap;
+    outputs out;
+    if (result.mask) {
+        lock_mask.emplace(*result.mask);
+        out.mask = &*result.mask;
+    }
+    if (result.heatmap) {
+        lock_heatmap.emplace(*result.heatmap);
+        out.heatmap = &*result.heatmap;
+        out.l = *detail::get_byte_layout(out.heatmap->pixel_format());
+    }
+    if (va->s->pixels() == nullptr || vb->s->pixels() == nullptr ||
+        (out.mask && out.mask->pixels() == nullptr) || (out.heatmap && out.heatmap->pixels() == nullptr))
+        return {};
+
+    auto const alpha = options.alpha && va->l.a >= 0 && vb->l.a >= 0;
+    auto const same_layout = va->l.bytes == 4 && vb->l.bytes == 4 && va->l.r == vb->l.r && va->l.g == vb->l.g && va->l.b == vb->l.b &&
+                             (!alpha || va->l.a == vb->l.a) && !out.mask && !out.heatmap;
+    auto keep = 0xFFu << (8 * va->l.r) | 0xFFu << (8 * va->l.g) | 0xFFu << (8 * va->l.b);
+    if (alpha)
+        keep |= 0xFFu << (8 * va->l.a);
+
+    auto const row_pixels = static_cast<std::size_t>(size.width);
+    totals sum;
+    for (auto const& t : detail::parallel_rows(size.height, row_pixels, options.threads, [&](int const begin, int const end) {
+             totals band;
+             for (int y = begin; y < end; ++y)
+                 band.add(same_layout ? compare_row_same(detail::row_at(*va->s, y), detail::row_at(*vb->s, y), size.width, keep)
+                                      : compare_row(*va, *vb, y, alpha, out));
+             return band;
+         }))
+        sum.add(t);
+
+    auto const samples = static_cast<double>(size.width) * size.height * (alpha ? 4 : 3);
+    result.differing_pixels = static_cast<std::size_t>(sum.differing);
+    result.max_error = sum.max;
+    result.mean_error = static_cast<double>(sum.sad) / samples;
+    result.mse = static_cast<double>(sum.sse) / samples;
+    if (sum.sse != 0)
+        result.psnr = 10.0 * std::log10(255.0 * 255.0 / result.mse);
+
+    if (options.ssim) {
+        auto const pixels = row_pixels * static_cast<std::size_t>(size.height);
+        std::vector<float> luma_a(pixels), luma_b(pixels);
+        detail::parallel_rows(size.height, row_pixels, options.threads, [&](int const begin, int const end) {
+            luma_rows(*va, luma_a.data(), begin, end);
+            luma_rows(*vb, luma_b.data(), begin, end);
+        });
+
+        // images smaller than the window are compared as one window
+        auto const window = std::clamp(options.ssim_window, 1, std::min(size.width, size.height));
+        auto const step = std::max(window / 2, 1);
+        ssim_totals ssim;
+        for (auto const& t : detail::parallel_rows(size.height, row_pixels, options.threads, [&](int const begin, int const end) {
+                 return ssim_rows(luma_a.data(), luma_b.data(), size, window, step, begin, end);
+             })) {
+            ssim.sum += t.sum;
+            ssim.windows += t.windows;
+        }
+        result.ssim = ssim.windows > 0 ? ssim.sum / static_cast<double>(ssim.windows) : 1.0;
+    }
+    return result;
+}
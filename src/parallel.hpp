@@ -0,0 +1,138 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "pixel_access.hpp"
+
+namespace sdl2::detail {
+
+/**
+ * @brief Below this many pixels per thread, starting a thread costs more than it saves.
+ */
+constexpr std::size_t min_pixels_per_thread = 1 << 16;
+
+/**
+ * @brief The most threads any of the helpers below starts, whatever the caller asks for.
+ */
+constexpr std::size_t max_threads = 64;
+
+/**
+ * @brief The number of ranges to split work across.
+ * @param items The number of items, which is the most ranges there can be.
+ * @param work The total cost of the items, in the unit of min_work.
+ * @param min_work The least work worth a thread of its own.
+ * @param threads The number of threads the caller allows.
+ * @return Between 1 and max_threads.
+ */
+inline std::size_t thread_count(std::size_t const items, std::size_t const work, std::size_t const min_work, std::size_t const threads) noexcept {
+    return std::clamp<std::size_t>(std::min({threads, work / std::max<std::size_t>(min_work, 1), items}), 1, max_threads);
+}
+
+/**
+ * @brief Split [0, n) into count ranges of equal size and run f(begin, end) for each, one range per thread,
+ * the caller taking the first.
+ * @return Nothing if f returns nothing, otherwise each range's result in order.
+ */
+template<class F>
+auto parallel_ranges(std::size_t const n, std::size_t const count, F const& f) {
+    using result = std::invoke_result_t<F const&, std::size_t, std::size_t>;
+    auto const step = (n + count - 1) / std::max<std::size_t>(count, 1);
+    auto const range = [&](std::size_t const t) {
+        auto const begin = std::min(t * step, n);
+        return std::pair{begin, std::min(begin + step, n)};
+    };
+
+    if constexpr (std::is_void_v<result>) {
+        if (count <= 1) {
+            f(std::size_t{0}, n);
+            return;
+        }
+        std::vector<std::jthread> workers;
+        workers.reserve(count - 1);
+        for (std::size_t t = 1; t < count; ++t) {
+            auto const [begin, end] = range(t);
+            workers.emplace_back([&f, begin, end] { f(begin, end); });
+        }
+        f(std::size_t{0}, range(0).second);
+    } else {
+        std::vector<result> results(std::max<std::size_t>(count, 1));
+        {
+            std::vector<std::jthread> workers;
+            workers.reserve(results.size() - 1);
+            for (std::size_t t = 1; t < results.size(); ++t) {
+                auto const [begin, end] = range(t);
+                workers.emplace_back([&f, &results, t, begin, end] { results[t] = f(begin, end); });
+            }
+            results[0] = f(std::size_t{0}, range(0).second);
+        }
+        return results;
+    }
+}
+
+/**
+ * @brief Run f(begin, end) over [0, n) split across up to threads threads of at least min_per_thread items each.
+ * @return Nothing if f returns nothing, otherwise each range's result in order.
+ */
+template<class F>
+auto parallel_for(std::size_t const n, std::size_t const min_per_thread, std::size_t const threads, F const& f) {
+    return parallel_ranges(n, thread_count(n, n, min_per_thread, threads), f);
+}
+
+/**
+ * @brief Run f(begin, end) over the rows [0, rows) split into bands across up to threads threads,
+ * at least min_pixels_per_thread pixels each, the caller taking the first band.
+ * @param rows The number of rows.
+ * @param row_pixels The pixels each row costs, e.g. its width times the kernel taps read per pixel.
+ * @param threads The number of threads the caller allows.
+ * @param f Called with int row bounds.
+ * @return Nothing if f returns nothing, otherwise each band's result in order.
+ */
+template<class F>
+auto parallel_rows(int const rows, std::size_t const row_pixels, std::size_t const threads, F const& f) {
+    auto const n = static_cast<std::size_t>(std::max(rows, 0));
+    return parallel_ranges(n, thread_count(n, n * row_pixels, min_pixels_per_thread, threads), [&f](std::size_t const begin, std::size_t const end) {
+        return f(static_cast<int>(begin), static_cast<int>(end));
+    });
+}
+
+/**
+ * @brief Run f(i) for every i in [0, n) on up to threads threads, each taking the next index when it is done,
+ * for items whose costs differ too much to split into equal ranges.
+ */
+template<class F>
+void for_each_index(std::size_t const n, std::size_t const threads, F const& f) {
+    std::atomic<std::size_t> next{0};
+    auto const work = [&] {
+        for (auto i = next++; i < n; i = next++)
+            f(i);
+    };
+    auto const count = std::clamp<std::size_t>(std::min(threads, n), 1, max_threads);
+    std::vector<std::jthread> workers;
+    workers.reserve(count - 1);
+    for (std::size_t t = 1; t < count; ++t)
+        workers.emplace_back(work);
+    work();
+}
+
+/**
+ * @brief Get the first byte of a row of a surface whose pixels are locked.
+ */
+inline std::uint8_t const* row_at(surface const& s, int const y) noexcept {
+    return reinterpret_cast<std::uint8_t const*>(pixel_at(s, 0, y));
+}
+
+/**
+ * @brief Get the first byte of a row of a surface whose pixels are locked.
+ */
+inline std::uint8_t* row_at(surface& s, int const y) noexcept {
+    return reinterpret_cast<std::uint8_t*>(pixel_at(s, 0, y));
+}
+
+} // namespace sdl2::detail
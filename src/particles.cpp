@@ -0,0 +1,134 @@
+#include "sdl2pp/particles.hpp"
+#include "sdl2pp/renderer.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#include "parallel.hpp"
+
+using namespace sdl2;
+
+namespace {
+
+// below this many particles per thread, starting a thread costs more than it saves
+constexpr std::size_t min_per_thread = 16384;
+
+// The kernels are plain loops over restrict pointers so that compilers vectorise them.
+void integrate_kernel(float* __restrict x, float* __restrict y, float* __restrict vx, float* __restrict vy,
+                      float* __restrict life, std::size_t const n, float const dt, float const ax, float const ay) noexcept {
+    for (std::size_t i = 0; i < n; ++i) {
+        vx[i] += ax * dt;
+        vy[i] += ay * dt;
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+        life[i] -= dt;
+    }
+}
+
+// writes four vertices per particle; alpha fades with the fraction of life left
+void build_kernel(float const* __restrict x, float const* __restrict y, float const* __restrict size,
+                  float const* __restrict life, float const* __restrict inv_life, SDL_Color const* __restrict color,
+                  SDL_Vertex* __restrict out, std::size_t const n, rect<float> const& uv) noexcept {
+    auto const u0 = uv.x(), v0 = uv.y(), u1 = uv.x() + uv.w(), v1 = uv.y() + uv.h();
+    for (std::size_t i = 0; i < n; ++i) {
+        auto const h = size[i] * 0.5f;
+        auto const x0 = x[i] - h, x1 = x[i] + h, y0 = y[i] - h, y1 = y[i] + h;
+        auto c = color[i];
+        c.a = static_cast<std::uint8_t>(static_cast<float>(c.a) * std::clamp(life[i] * inv_life[i], 0.0f, 1.0f) + 0.5f);
+
+        auto* const v = out + 4 * i;
+        v[0] = {{x0, y0}, c, {u0, v0}};
+        v[1] = {{x1, y0}, c, {u1, v0}};
+        v[2] = {{x1, y1}, c, {u1, v1}};
+        v[3] = {{x0, y1}, c, {u0, v1}};
+    }
+}
+
+} // namespace
+
+particle_emitter::particle_emitter(texture const& txr, std::size_t const capacity, std::optional<rect<int>> const src)
+    : texture_{txr}
+    // four vertices per particle must stay addressable by SDL's int indices
+    , capacity_{std::min<std::size_t>(capacity, std::numeric_limits<int>::max() / 6)}
+    , x_(capacity_), y_(capacity_), vx_(capacity_), vy_(capacity_), life_(capacity_), inv_life_(capacity_), sizes_(capacity_)
+    , color_(capacity_)
+    , vertices_(4 * capacity_)
+    , indices_(6 * capacity_)
+{
+    auto const tsize = txr.size();
+    auto const area = src.value_or(rect<int>{0, 0, tsize.width, tsize.height});
+    auto const tw = static_cast<float>(std::max(tsize.width, 1)), th = static_cast<float>(std::max(tsize.height, 1));
+    uv_ = {static_cast<float>(area.x()) / tw, static_cast<float>(area.y()) / th, static_cast<float>(area.w()) / tw, static_cast<float>(area.h()) / th};
+
+    // the index pattern never changes, so it is written once for the whole capacity
+    for (std::size_t i = 0; i < capacity_; ++i) {
+        auto const base = static_cast<int>(4 * i);
+        auto* const idx = indices_.data() + 6 * i;
+        idx[0] = base;
+        idx[1] = base + 1;
+        idx[2] = base + 2;
+        idx[3] = base;
+        idx[4] = base + 2;
+        idx[5] = base + 3;
+    }
+}
+
+bool particle_emitter::emit(particle const& p) noexcept {
+    if (count_ == capacity_ || !(p.life > 0.0f))
+        return false;
+    auto const i = count_++;
+    x_[i] = p.position.x;
+    y_[i] = p.position.y;
+    vx_[i] = p.velocity.x;
+    vy_[i] = p.velocity.y;
+    life_[i] = p.life;
+    inv_life_[i] = 1.0f / p.life;
+    sizes_[i] = p.size;
+    color_[i] = {p.color.r, p.color.g, p.color.b, p.color.a};
+    return true;
+}
+
+std::size_t particle_emitter::emit(std::span<particle const> const ps) noexcept {
+    std::size_t added = 0;
+    for (auto const& p : ps) {
+        if (count_ == capacity_)
+            break;
+        added += emit(p) ? 1 : 0;
+    }
+    return added;
+}
+
+void particle_emitter::update(float const dt, xy<float> const acceleration, std::size_t const threads) {
+    detail::parallel_for(count_, min_per_thread, threads, [&](std::size_t const begin, std::size_t const end) {
+        integrate_kernel(x_.data() + begin, y_.data() + begin, vx_.data() + begin, vy_.data() + begin,
+                         life_.data() + begin, end - begin, dt, acceleration.x, acceleration.y);
+    });
+
+    // swap the dead with the last live particles; a single pass keeps this cheap when few die per frame
+    for (std::size_t i = 0; i < count_;) {
+        if (life_[i] > 0.0f) {
+            ++i;
+            continue;
+        }
+        auto const last = --count_;
+        x_[i] = x_[last];
+        y_[i] = y_[last];
+        vx_[i] = vx_[last];
+        vy_[i] = vy_[last];
+        life_[i] = life_[last];
+        inv_life_[i] = inv_life_[last];
+        sizes_[i] = sizes_[last];
+        color_[i] = color_[last];
+    }
+}
+
+bool particle_emitter::draw(renderer& r, std::size_t const threads) {
+    if (count_ == 0)
+        return true;
+
+    detail::parallel_for(count_, min_per_thread, threads, [&](std::size_t const begin, std::size_t const end) {
+        build_kernel(x_.data() + begin, y_.data() + begin, sizes_.data() + begin, life_.data() + begin, inv_life_.data() + begin,
+                     color_.data() + begin, vertices_.data() + 4 * begin, end - begin, uv_);
+    });
+    return r.render_geometry(texture_, std::span{vertices_}.first(4 * count_), std::span{indices_}.first(6 * count_));
+}
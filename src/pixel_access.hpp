@@ -0,0 +1,189 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+
+#include "sdl2pp/pixel.hpp"
+#include "sdl2pp/surface.hpp"
+
+namespace sdl2::detail {
+
+/**
+ * @brief Locks a surface for direct pixel access for the lifetime of the guard, if the surface requires it.
+ */
+class surface_lock_guard {
+    surface& s_;
+    bool const locked_;
+
+public:
+    explicit surface_lock_guard(surface& s) noexcept
+        : s_{s}, locked_{s.must_lock()}
+    {
+        if (locked_)
+            s_.lock();
+    }
+
+    surface_lock_guard(surface_lock_guard const&) = delete;
+    surface_lock_guard& operator=(surface_lock_guard const&) = delete;
+
+    ~surface_lock_guard() noexcept {
+        if (locked_)
+            s_.unlock();
+    }
+};
+
+/**
+ * @brief The pixels a blit touches: the destination rect and the matching top-left pixel of the source.
+ */
+struct blit_area {
+    rect<int> dst{0, 0, 0, 0};
+    xy<int> src{};
+};
+
+/**
+ * @brief Clip a blit like SDL_BlitSurface: the source rect to the source, then the result to dst's clip rect.
+ * @param src The source surface.
+ * @param srcrect The area of the source to copy, or nullptr for all of it.
+ * @param dst The destination surface.
+ * @param at The position in dst of srcrect's top-left corner.
+ * @return The clipped area, whose dst rect is empty when nothing is visible.
+ */
+inline blit_area clip_blit(surface const& src, rect<int> const* const srcrect, surface const& dst, xy<int> const at) noexcept {
+    auto const sr = srcrect ? *srcrect : rect<int>{0, 0, src.width(), src.height()};
+    blit_area area;
+    if (auto const sc = sr.intersection({0, 0, src.width(), src.height()})) {
+        auto const x = at.x + sc->x() - sr.x();
+        auto const y = at.y + sc->y() - sr.y();
+        if (auto const dc = rect<int>{x, y, sc->w(), sc->h()}.intersection(dst.clip_rect())) {
+            area.dst = *dc;
+            area.src = {sc->x() + dc->x() - x, sc->y() + dc->y() - y};
+        }
+    }
+    return area;
+}
+
+/**
+ * @brief Byte offsets of each 8-bit channel within a pixel. a is -1 when the format has no alpha.
+ */
+struct byte_layout {
+    int bytes = 0;
+    int r = 0, g = 0, b = 0, a = -1;
+};
+
+/**
+ * @brief Describe a format whose channels each occupy a whole byte (e.g. RGBA8888, BGR24).
+ * @param fmt The format to describe.
+ * @return The byte offsets, or an empty optional for packed, indexed or FOURCC formats.
+ */
+inline std::optional<byte_layout> get_byte_layout(const_pixel_format_view const fmt) noexcept {
+    auto const bpp = fmt.bytes_per_pixel();
+    if (fmt.has_palette() || (bpp != 3 && bpp != 4))
+        return {};
+
+    auto const offset = [bpp](std::uint32_t const mask) -> int {
+        if (mask == 0)
+            return -1;
+        auto const shift = std::countr_zero(mask);
+        if ((shift % 8) != 0 || (mask >> shift) != 0xFF)
+            return -2;
+        auto const byte = shift / 8;
+        return std::endian::native == std::endian::little ? byte : bpp - 1 - byte;
+    };
+
+    byte_layout l{bpp, offset(fmt.rmask()), offset(fmt.gmask()), offset(fmt.bmask()), offset(fmt.amask())};
+    if (l.r < 0 || l.g < 0 || l.b < 0 || l.a == -2)
+        return {};
+    return l;
+}
+
+/**
+ * @brief Exact round(x / 255) for x in [0, 65535 - 128).
+ */
+constexpr std::uint32_t div255(std::uint32_t const x) noexcept {
+    auto const t = x + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+/**
+ * @brief Straight-alpha lerp of one channel: d + (s - d) * a / 255, rounded.
+ */
+constexpr std::uint8_t blend_channel(std::uint8_t const d, std::uint8_t const s, std::uint32_t const a) noexcept {
+    return static_cast<std::uint8_t>(div255(s * a + d * (255 - a)));
+}
+
+/**
+ * @brief Undo premultiplication of one channel: round(c * 255 / a), saturated, and 0 when a is 0.
+ */
+inline std::uint8_t unpremultiply_channel(std::uint8_t const c, std::uint8_t const a) noexcept {
+    static auto const table = [] {
+        std::array<std::uint8_t, 256 * 256> t{};
+        for (std::uint32_t alpha = 1; alpha < 256; ++alpha) {
+            for (std::uint32_t v = 0; v < 256; ++v)
+                t[alpha * 256 + v] = static_cast<std::uint8_t>(std::min<std::uint32_t>(255, (v * 255 + alpha / 2) / alpha));
+        }
+        return t;
+    }();
+    return table[a * 256u + c];
+}
+
+/**
+ * @brief Get a pointer to the first byte of a pixel.
+ */
+inline std::byte* pixel_at(surface& s, int const x, int const y) noexcept {
+    return static_cast<std::byte*>(s.pixels()) + static_cast<std::ptrdiff_t>(y) * s.pitch() + static_cast<std::ptrdiff_t>(x) * s.pixel_format().bytes_per_pixel();
+}
+
+/**
+ * @brief Get a pointer to the first byte of a pixel.
+ */
+inline std::byte const* pixel_at(surface const& s, int const x, int const y) noexcept {
+    return static_cast<std::byte const*>(s.pixels()) + static_cast<std::ptrdiff_t>(y) * s.pitch() + static_cast<std::ptrdiff_t>(x) * s.pixel_format().bytes_per_pixel();
+}
+
+/**
+ * @brief Read a pixel value of 1 to 4 bytes.
+ */
+inline std::uint32_t load_pixel(std::byte const* const p, int const bytes) noexcept {
+    switch (bytes) {
+    case 1: return std::to_integer<std::uint32_t>(p[0]);
+    case 2: { std::uint16_t v; std::memcpy(&v, p, 2); return v; }
+    case 3: {
+        auto const b0 = std::to_integer<std::uint32_t>(p[0]);
+        auto const b1 = std::to_integer<std::uint32_t>(p[1]);
+        auto const b2 = std::to_integer<std::uint32_t>(p[2]);
+        return std::endian::native == std::endian::little ? (b0 | (b1 << 8) | (b2 << 16)) : ((b0 << 16) | (b1 << 8) | b2);
+    }
+    default: { std::uint32_t v; std::memcpy(&v, p, 4); return v; }
+    }
+}
+
+/**
+ * @brief Write a pixel value of 1 to 4 bytes.
+ */
+inline void store_pixel(std::byte* const p, int const bytes, std::uint32_t const v) noexcept {
+    switch (bytes) {
+    case 1: p[0] = static_cast<std::byte>(v); break;
+    case 2: { auto const v16 = static_cast<std::uint16_t>(v); std::memcpy(p, &v16, 2); break; }
+    case 3:
+        if constexpr (std::endian::native == std::endian::little) {
+            p[0] = static_cast<std::byte>(v);
+            p[1] = static_cast<std::byte>(v >> 8);
+            p[2] = static_cast<std::byte>(v >> 16);
+        } else {
+            p[0] = static_cast<std::byte>(v >> 16);
+            p[1] = static_cast<std::byte>(v >> 8);
+            p[2] = static_cast<std::byte>(v);
+        }
+        break;
+    default: std::memcpy(p, &v, 4); break;
+    }
+}
+
+} // namespace sdl2::detail
@@ -0,0 +1,316 @@
+#include "sdl2pp/qoi.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <optional>
+
+#include "parallel.hpp"
+#include "pixel_access.hpp"
+
+using namespace sdl2;
+
+namespace {
+
+// https://qoiformat.org/qoi-specification.pdf
+constexpr std::uint8_t op_index = 0x00;
+constexpr std::uint8_t op_diff = 0x40;
+constexpr std::uint8_t op_luma = 0x80;
+constexpr std::uint8_t op_run = 0xC0;
+constexpr std::uint8_t op_rgb = 0xFE;
+constexpr std::uint8_t op_rgba = 0xFF;
+constexpr std::uint8_t op_mask = 0xC0;
+
+constexpr std::size_t header_size = 14;
+constexpr std::array<std::uint8_t, 8> end_marker{0, 0, 0, 0, 0, 0, 0, 1};
+constexpr std::uint64_t max_pixels = 400'000'000;
+
+// streams write in chunks of this many bytes
+constexpr std::size_t chunk_size = 1 << 16;
+
+// the index starts all zero while the previous pixel starts as opaque black
+struct qoi_rgba {
+    std::uint8_t r, g, b, a;
+    bool operator==(qoi_rgba const&) const = default;
+};
+
+constexpr std::size_t hash(qoi_rgba const p) noexcept {
+    return (p.r * 3u + p.g * 5u + p.b * 7u + p.a * 11u) % 64u;
+}
+
+// Collects the encoded bytes, passing them on to a stream whenever a chunk is full if there is one.
+class byte_sink {
+    std::vector<std::byte>& buf_;
+    SDL_RWops* rw_;
+    bool ok_ = true;
+
+public:
+    byte_sink(std::vector<std::byte>& buf, SDL_RWops* const rw) noexcept : buf_{buf}, rw_{rw} {}
+
+    void put(std::uint8_t const b) {
+        buf_.push_back(static_cast<std::byte>(b));
+        if (rw_ && buf_.size() >= chunk_size)
+            flush();
+    }
+
+    void put32(std::uint32_t const v) {
+        for (int shift = 24; shift >= 0; shift -= 8)
+            put(static_cast<std::uint8_t>(v >> shift));
+    }
+
+    bool flush() noexcept {
+        if (rw_ && !buf_.empty()) {
+            ok_ = ok_ && SDL_RWwrite(rw_, buf_.data(), buf_.size(), 1) == 1;
+            buf_.clear();
+        }
+        return ok_;
+    }
+};
+
+bool encode(surface const& s, byte_sink& out) {
+    if (!s || s.width() <= 0 || s.height() <= 0 ||
+        static_cast<std::uint64_t>(s.width()) * static_cast<std::uint64_t>(s.height()) > max_pixels)
+        return false;
+
+    // formats whose channels are whole bytes are read in place, anything else goes through ARGB8888
+    auto const channels = s.pixel_format().amask() != 0 ? 4 : 3;
+    surface const* src = &s;
+    std::optional<surface> converted;
+    auto layout = detail::get_byte_layout(s.pixel_format());
+    if (!layout) {
+        converted.emplace(s.convert_to_new(sdl2::pixel_format{pixel_format_enum::ARGB8888}));
+        if (!*converted)
+            return false;
+        src = &*converted;
+        layout = detail::get_byte_layout(src->pixel_format());
+        if (!layout)
+            return false;
+    }
+
+    detail::surface_lock_guard const lock{const_cast<surface&>(*src)};
+    if (src->pixels() == nullptr)
+        return false;
+
+    for (auto const b : {std::uint8_t{'q'}, std::uint8_t{'o'}, std::uint8_t{'i'}, std::uint8_t{'f'}})
+        out.put(b);
+    out.put32(static_cast<std::uint32_t>(src->width()));
+    out.put32(static_cast<std::uint32_t>(src->height()));
+    out.put(static_cast<std::uint8_t>(channels));
+    out.put(0);
+
+    std::array<qoi_rgba, 64> index{};
+    qoi_rgba prev{0, 0, 0, 255};
+    int run = 0;
+    auto const l = *layout;
+    for (int y = 0; y < src->height(); ++y) {
+        auto const* const row = reinterpret_cast<std::uint8_t const*>(detail::pixel_at(*src, 0, y));
+        for (int x = 0; x < src->width(); ++x) {
+            auto const* const p = row + l.bytes * x;
+            qoi_rgba const px{p[l.r], p[l.g], p[l.b], channels == 4 ? p[l.a] : std::uint8_t{255}};
+            if (px == prev) {
+                if (++run == 62) {
+                    out.put(static_cast<std::uint8_t>(op_run | (run - 1)));
+                    run = 0;
+                }
+                continue;
+            }
+            if (run > 0) {
+                out.put(static_cast<std::uint8_t>(op_run | (run - 1)));
+                run = 0;
+            }
+
+            auto const h = hash(px);
+            if (index[h] == px) {
+                out.put(static_cast<std::uint8_t>(op_index | h));
+            } else {
+                index[h] = px;
+                if (px.a == prev.a) {
+                    // differences wrap around, as the decoder adds them modulo 256
+                    auto const vr = static_cast<std::int8_t>(px.r - prev.r);
+                    auto const vg = static_cast<std::int8_t>(px.g - prev.g);
+                    auto const vb = static_cast<std::int8_t>(px.b - prev.b);
+                    auto const vg_r = vr - vg, vg_b = vb - vg;
+                    if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+                        out.put(static_cast<std::uint8_t>(op_diff | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2)));
+                    } else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8) {
+                        out.put(static_cast<std::uint8_t>(op_luma | (vg + 32)));
+                        out.put(static_cast<std::uint8_t>((vg_r + 8) << 4 | (vg_b + 8)));
+                    } else {
+                        out.put(op_rgb);
+                        out.put(px.r);
+                        out.put(px.g);
+                        out.put(px.b);
+                    }
+                } else {
+                    out.put(op_rgba);
+                    out.put(px.r);
+                    out.put(px.g);
+                    out.put(px.b);
+                    out.put(px.a);
+                }
+            }
+            prev = px;
+        }
+    }
+    if (run > 0)
+        out.put(static_cast<std::uint8_t>(op_run | (run - 1)));
+    for (auto const b : end_marker)
+        out.put(b);
+    return out.flush();
+}
+
+std::uint32_t get32(std::span<std::byte const> const data, std::size_t const at) noexcept {
+    return static_cast<std::uint32_t>(data[at]) << 24 | static_cast<std::uint32_t>(data[at + 1]) << 16 |
+           static_cast<std::uint32_t>(data[at + 2]) << 8 | static_cast<std::uint32_t>(data[at + 3]);
+}
+
+// decodes the chunks after the header into out, which has the image's size; false if the data runs out
+bool decode(std::span<std::byte const> const data, surface& out) noexcept {
+    auto const layout = detail::get_byte_layout(out.pixel_format());
+    detail::surface_lock_guard const lock{out};
+    if (!layout || out.pixels() == nullptr)
+        return false;
+
+    auto const l = *layout;
+    auto const end = data.size() - end_marker.size();
+    auto const byte = [&data](std::size_t const i) { return static_cast<std::uint8_t>(data[i]); };
+    std::array<qoi_rgba, 64> index{};
+    qoi_rgba px{0, 0, 0, 255};
+    std::size_t pos = header_size;
+    int run = 0;
+    for (int y = 0; y < out.height(); ++y) {
+        auto* const row = reinterpret_cast<std::uint8_t*>(detail::pixel_at(out, 0, y));
+        for (int x = 0; x < out.width(); ++x) {
+            if (run > 0) {
+                --run;
+            } else {
+                if (pos >= end)
+                    return false;
+                auto const b1 = byte(pos++);
+                if (b1 == op_rgb || b1 == op_rgba) {
+                    if (end - pos < (b1 == op_rgb ? 3u : 4u))
+                        return false;
+                    px.r = byte(pos++);
+                    px.g = byte(pos++);
+                    px.b = byte(pos++);
+                    if (b1 == op_rgba)
+                        px.a = byte(pos++);
+                } else if ((b1 & op_mask) == op_index) {
+                    px = index[b1];
+                } else if ((b1 & op_mask) == op_diff) {
+                    px.r = static_cast<std::uint8_t>(px.r + ((b1 >> 4) & 3) - 2);
+                    px.g = static_cast<std::uint8_t>(px.g + ((b1 >> 2) & 3) - 2);
+                    px.b = static_cast<std::uint8_t>(px.b + (b1 & 3) - 2);
+                } else if ((b1 & op_mask) == op_luma) {
+                    if (pos >= end)
+                        return false;
+                    auto const b2 = byte(pos++);
+                    auto const vg = (b1 & 0x3F) - 32;
+                    px.r = static_cast<std::uint8_t>(px.r + vg - 8 + ((b2 >> 4) & 0x0F));
+                    px.g = static_cast<std::uint8_t>(px.g + vg);
+                    px.b = static_cast<std::uint8_t>(px.b + vg - 8 + (b2 & 0x0F));
+                } else {
+                    run = b1 & 0x3F;
+                }
+                index[hash(px)] = px;
+            }
+
+            auto* const p = row + l.bytes * x;
+            p[l.r] = px.r;
+            p[l.g] = px.g;
+            p[l.b] = px.b;
+            if (l.a >= 0)
+                p[l.a] = px.a;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+std::vector<std::byte> sdl2::qoi_encode(surface const& s) {
+    std::vector<std::byte> out;
+    if (s)
+        out.reserve(header_size + end_marker.size() + static_cast<std::size_t>(s.width()) * static_cast<std::size_t>(s.height()) * 2);
+    byte_sink sink{out, nullptr};
+    if (!encode(s, sink))
+        out.clear();
+    return out;
+}
+
+bool sdl2::qoi_encode(surface const& s, SDL_RWops& dst) {
+    std::vector<std::byte> buf;
+    buf.reserve(chunk_size);
+    byte_sink sink{buf, &dst};
+    return encode(s, sink);
+}
+
+bool sdl2::qoi_save(surface const& s, null_term_string const file) {
+    auto* const rw = SDL_RWFromFile(file.data(), "wb");
+    if (rw == nullptr)
+        return false;
+    auto const ok = qoi_encode(s, *rw);
+    return SDL_RWclose(rw) == 0 && ok;
+}
+
+surface sdl2::qoi_decode(std::span<std::byte const> const data) {
+    if (data.size() < header_size + end_marker.size())
+        return surface{nullptr};
+    auto const magic = get32(data, 0), width = get32(data, 4), height = get32(data, 8);
+    auto const channels = static_cast<int>(data[12]), colorspace = static_cast<int>(data[13]);
+    if (magic != 0x716F6966 || width == 0 || height == 0 || (channels != 3 && channels != 4) || colorspace > 1 ||
+        width > static_cast<std::uint32_t>(std::numeric_limits<int>::max()) || height > static_cast<std::uint32_t>(std::numeric_limits<int>::max()) ||
+        static_cast<std::uint64_t>(width) * height > max_pixels)
+        return surface{nullptr};
+
+    surface out{channels == 4 ? pixel_format_enum::RGBA32 : pixel_format_enum::RGB24, channels * 8, {static_cast<int>(width), static_cast<int>(height)}};
+    if (!out || !decode(data, out))
+        return surface{nullptr};
+    return out;
+}
+
+surface sdl2::qoi_decode(SDL_RWops& src) {
+    std::vector<std::byte> data;
+    for (;;) {
+        auto const old = data.size();
+        data.resize(old + chunk_size);
+        auto const n = SDL_RWread(&src, data.data() + old, 1, chunk_size);
+        data.resize(old + n);
+        if (n == 0)
+            break;
+    }
+    return qoi_decode(data);
+}
+
+surface sdl2::qoi_load(null_term_string const file) {
+    auto* const rw = SDL_RWFromFile(file.data(), "rb");
+    if (rw == nullptr)
+        return surface{nullptr};
+    auto out = qoi_decode(*rw);
+    SDL_RWclose(rw);
+    return out;
+}
+
+std::vector<std::vector<std::byte>> sdl2::qoi_encode_batch(std::span<surface const* const> const images, std::size_t const threads) {
+    std::vector<std::vector<std::byte>> out(images.size());
+    detail::for_each_index(images.size(), threads, [&](std::size_t const i) {
+        if (images[i] != nullptr)
+            out[i] = qoi_encode(*images[i]);
+    });
+    return out;
+}
+
+std::vector<surface> sdl2::qoi_decode_batch(std::span<std::span<std::byte const> const> const images, std::size_t const threads) {
+    // surfaces cannot be move-assigned, so results land in optionals and are moved out in order
+    std::vector<std::optional<surface>> decoded(images.size());
+    detail::for_each_index(images.size(), threads, [&](std::size_t const i) {
+        decoded[i].emplace(qoi_decode(images[i]));
+    });
+
+    std::vector<surface> out;
+    out.reserve(decoded.size());
+    for (auto& d : decoded)
+        out.push_back(std::move(*d));
+    return out;
+}
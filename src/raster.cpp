@@ -0,0 +1,533 @@
+#include "sdl2pp/raster.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <vector>
+
+#include "pixel_access.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SDL2PP_RASTER_SSE2 1
+#endif
+
+using namespace sdl2;
+
+namespace {
+
+/**
+ * Writes coverage-weighted spans of a single color into a locked surface, clipped to its clip rect.
+ * Pixels are blended as dst + (color - dst) * color.a * coverage, with the destination alpha (if any)
+ * accumulating like SDL's blend mode. Formats with whole-byte channels are blended byte-wise, which
+ * is exact because the source pixel is mapped with full alpha; every other format round trips
+ * through SDL_GetRGBA/SDL_MapRGBA.
+ */
+class canvas {
+    surface& s_;
+    detail::surface_lock_guard lock_;
+    rect<int> clip_;
+    int bpp_;
+    bool byte_aligned_;
+    std::uint8_t alpha_;
+    std::uint32_t src_;
+    std::uint8_t src_bytes_[4]{};
+
+public:
+    canvas(surface& s, rgba<> const color) noexcept
+        : s_{s}
+        , lock_{s}
+        , clip_{}
+        , bpp_{s.pixel_format().bytes_per_pixel()}
+        , byte_aligned_{detail::get_byte_layout(s.pixel_format()).has_value()}
+        , alpha_{color.a}
+        , src_{SDL_MapRGBA(s.pixel_format().native_handle(), color.r, color.g, color.b, 255)}
+    {
+        if (auto const c = s.clip_rect().intersection({0, 0, s.width(), s.height()}))
+            clip_ = *c;
+        if (byte_aligned_)
+            detail::store_pixel(reinterpret_cast<std::byte*>(src_bytes_), bpp_, src_);
+    }
+
+    bool ok() const noexcept { return s_.pixels() != nullptr && bpp_ >= 1 && bpp_ <= 4; }
+    rect<int> const& clip() const noexcept { return clip_; }
+
+    /**
+     * @brief Cover [x0, x1) on row y, which must already be inside the clip rect.
+     * @param coverage The fraction of each pixel covered, from 0 to 255.
+     */
+    void span(int const y, int const x0, int const x1, std::uint32_t const coverage) noexcept {
+        auto const a = detail::div255(alpha_ * coverage);
+        if (a == 0 || x1 <= x0)
+            return;
+        auto* const p = detail::pixel_at(s_, x0, y);
+        if (a == 255)
+            fill(p, x1 - x0);
+        else if (byte_aligned_)
+            blend_bytes(p, x1 - x0, a);
+        else
+            blend_mapped(p, x1 - x0, a);
+    }
+
+    /**
+     * @brief Cover a single pixel, ignoring it if it falls outside the clip rect.
+     * @param coverage The fraction of the pixel covered, from 0 to 1.
+     */
+    void plot(long long const x, long long const y, float const coverage) noexcept {
+        if (x < clip_.x() || x >= clip_.x() + clip_.w() || y < clip_.y() || y >= clip_.y() + clip_.h())
+            return;
+        auto const xi = static_cast<int>(x);
+        span(static_cast<int>(y), xi, xi + 1, quantize(coverage));
+    }
+
+    static std::uint32_t quantize(float const coverage) noexcept {
+        return static_cast<std::uint32_t>(std::clamp(coverage, 0.f, 1.f) * 255.f + 0.5f);
+    }
+
+private:
+    void fill(std::byte* p, int const n) noexcept {
+        switch (bpp_) {
+        case 1:
+            std::memset(p, static_cast<int>(src_ & 0xFF), static_cast<std::size_t>(n));
+            break;
+        case 4: {
+            int i = 0;
+#ifdef SDL2PP_RASTER_SSE2
+            auto const v = _mm_set1_epi32(static_cast<int>(src_));
+            for (; i + 4 <= n; i += 4, p += 16)
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+#endif
+            for (; i < n; ++i, p += 4)
+                std::memcpy(p, &src_, 4);
+            break;
+        }
+        default:
+            for (int i = 0; i < n; ++i, p += bpp_)
+                detail::store_pixel(p, bpp_, src_);
+            break;
+        }
+    }
+
+    void blend_bytes(std::byte* p, int const n, std::uint32_t const a) noexcept {
+        auto const bytes = n * bpp_;
+        int i = 0;
+#ifdef SDL2PP_RASTER_SSE2
+        if (bpp_ == 4) {
+            // 4 pixels per iteration as 16-bit lanes; s * a + 128 is loop invariant
+            auto const zero = _mm_setzero_si128();
+            auto const s = _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(src_)), zero);
+            auto const sa = _mm_add_epi16(_mm_mullo_epi16(s, _mm_set1_epi16(static_cast<short>(a))), _mm_set1_epi16(128));
+            auto const ia = _mm_set1_epi16(static_cast<short>(255 - a));
+            auto const div255 = [](__m128i const t) {
+                return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+            };
+            for (; i + 16 <= bytes; i += 16) {
+                auto* const q = reinterpret_cast<__m128i*>(p + i);
+                auto const d = _mm_loadu_si128(q);
+                auto const lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), ia), sa);
+                auto const hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), ia), sa);
+                _mm_storeu_si128(q, _mm_packus_epi16(div255(lo), div255(hi)));
+            }
+        }
+#endif
+        for (int k = i % bpp_; i < bytes; ++i, k = (k + 1 == bpp_ ? 0 : k + 1)) {
+            auto const d = std::to_integer<std::uint8_t>(p[i]);
+            p[i] = static_cast<std::byte>(detail::blend_channel(d, src_bytes_[k], a));
+        }
+    }
+
+    void blend_mapped(std::byte* p, int const n, std::uint32_t const a) noexcept {
+        auto* const fmt = s_.pixel_format().native_handle();
+        std::uint8_t sr, sg, sb, sa;
+        SDL_GetRGBA(src_, fmt, &sr, &sg, &sb, &sa);
+        for (int i = 0; i < n; ++i, p += bpp_) {
+            std::uint8_t r, g, b, da;
+            SDL_GetRGBA(detail::load_pixel(p, bpp_), fmt, &r, &g, &b, &da);
+            detail::store_pixel(p, bpp_, SDL_MapRGBA(fmt,
+                detail::blend_channel(r, sr, a), detail::blend_channel(g, sg, a),
+                detail::blend_channel(b, sb, a), detail::blend_channel(da, 255, a)));
+        }
+    }
+};
+
+/**
+ * A set of directed edges filled with exact area coverage. Each edge adds its signed area to the
+ * cells it crosses on a row and a prefix sum over the row yields the winding-weighted coverage,
+ * clamped to one (non-zero rule). Rows are processed one at a time through an active edge list,
+ * so memory stays proportional to the clip width and interior runs come out as single spans.
+ */
+class edge_list {
+    struct edge {
+        float x0, y0, x1, y1;
+        float dir;
+    };
+
+    rect<float> clip_;
+    std::vector<edge> edges_;
+
+public:
+    explicit edge_list(rect<int> const& clip) noexcept
+        : clip_{static_cast<float>(clip.x()), static_cast<float>(clip.y()), static_cast<float>(clip.w()), static_cast<float>(clip.h())}
+    {}
+
+    void add_contour(std::span<point<float> const> const points) {
+        if (points.size() < 3)
+            return;
+        for (std::size_t i = 0; i < points.size(); ++i)
+            add_edge(points[i], points[(i + 1) % points.size()]);
+    }
+
+    void add_edge(point<float> const& a, point<float> const& b) {
+        auto const l = clip_.x(), r = clip_.x() + clip_.w();
+        auto const ax = a.x(), ay = a.y(), bx = b.x(), by = b.y();
+        if (!std::isfinite(ax) || !std::isfinite(ay) || !std::isfinite(bx) || !std::isfinite(by) || ay == by)
+            return;
+
+        // split at the vertical clip edges; the parts outside are pinned to the edge they cross,
+        // which leaves the accumulated winding inside the clip unchanged
+        float ts[4] = {0.f, 0.f, 0.f, 1.f};
+        int n = 1;
+        for (auto const xc : {l, r}) {
+            if ((ax - xc) * (bx - xc) < 0.f)
+                ts[n++] = (xc - ax) / (bx - ax);
+        }
+        ts[n] = 1.f;
+        std::sort(ts + 1, ts + n);
+        for (int i = 0; i < n; ++i) {
+            auto const ya = ay + (by - ay) * ts[i];
+            auto const yb = ay + (by - ay) * ts[i + 1];
+            auto const xa = std::clamp(ax + (bx - ax) * ts[i], l, r);
+            auto const xb = std::clamp(ax + (bx - ax) * ts[i + 1], l, r);
+            if (ya < yb)
+                edges_.push_back({xa - l, ya, xb - l, yb, 1.f});
+            else if (ya > yb)
+                edges_.push_back({xb - l, yb, xa - l, ya, -1.f});
+        }
+    }
+
+    void fill(canvas& c) {
+        auto const& clip = c.clip();
+        if (edges_.empty() || clip.empty())
+            return;
+
+        std::sort(edges_.begin(), edges_.end(), [](edge const& a, edge const& b) { return a.y0 < b.y0; });
+
+        auto const width = clip.w();
+        std::vector<float> acc(static_cast<std::size_t>(width) + 2, 0.f);
+        std::vector<edge const*> active;
+
+        auto const top = std::max(clip.y(), static_cast<int>(std::floor(edges_.front().y0)));
+        auto const bottom = clip.y() + clip.h();
+        auto next = edges_.begin();
+        for (int y = top; y < bottom; ++y) {
+            auto const fy = static_cast<float>(y);
+            std::erase_if(active, [fy](edge const* e) { return e->y1 <= fy; });
+            for (; next != edges_.end() && next->y0 < fy + 1.f; ++next) {
+                if (next->y1 > fy)
+                    active.push_back(&*next);
+            }
+            if (active.empty()) {
+                if (next == edges_.end())
+                    break;
+                continue;
+            }
+
+            int lo = width + 1, hi = 0;
+            for (auto const* e : active)
+                accumulate(*e, fy, acc.data(), lo, hi);
+            emit(c, y, acc.data(), lo, hi);
+        }
+        edges_.clear();
+    }
+
+private:
+    // add the signed area an edge contributes to each cell of row y
+    static void accumulate(edge const& e, float const y, float* const a, int& lo, int& hi) noexcept {
+        auto const ys = std::max(y, e.y0);
+        auto const ye = std::min(y + 1.f, e.y1);
+        if (ye <= ys)
+            return;
+
+        auto const dxdy = (e.x1 - e.x0) / (e.y1 - e.y0);
+        auto const xs = e.x0 + (ys - e.y0) * dxdy;
+        auto const xe = e.x0 + (ye - e.y0) * dxdy;
+        auto const d = (ye - ys) * e.dir;
+        auto const x0 = std::min(xs, xe), x1 = std::max(xs, xe);
+        auto const x0f = std::floor(x0);
+        auto const x0i = static_cast<int>(x0f);
+        auto const x1c = std::ceil(x1);
+        auto const x1i = static_cast<int>(x1c);
+
+        lo = std::min(lo, x0i);
+        if (x1i <= x0i + 1) {
+            // the edge stays within one cell; its coverage splits at the mean x
+            auto const xm = 0.5f * (xs + xe) - x0f;
+            a[x0i] += d - d * xm;
+            a[x0i + 1] += d * xm;
+            hi = std::max(hi, x0i + 1);
+            return;
+        }
+
+        auto const s = 1.f / (x1 - x0);
+        auto const f0 = x0 - x0f;
+        auto const a0 = 0.5f * s * (1.f - f0) * (1.f - f0);
+        auto const f1 = x1 - x1c + 1.f;
+        auto const am = 0.5f * s * f1 * f1;
+        a[x0i] += d * a0;
+        if (x1i == x0i + 2) {
+            a[x0i + 1] += d * (1.f - a0 - am);
+        } else {
+            auto const a1 = s * (1.5f - f0);
+            a[x0i + 1] += d * (a1 - a0);
+            for (int xi = x0i + 2; xi < x1i - 1; ++xi)
+                a[xi] += d * s;
+            auto const a2 = a1 + static_cast<float>(x1i - x0i - 3) * s;
+            a[x1i - 1] += d * (1.f - a2 - am);
+        }
+        a[x1i] += d * am;
+        hi = std::max(hi, x1i);
+    }
+
+    // prefix sum the row into runs of equal coverage, clearing the accumulator as it goes
+    static void emit(canvas& c, int const y, float* const a, int const lo, int const hi) noexcept {
+        auto const width = c.clip().w();
+        auto const x = c.clip().x();
+        float sum = 0.f;
+        int run_start = lo;
+        std::uint32_t run_cov = 0;
+        for (int i = lo; i <= hi; ++i) {
+            sum += a[i];
+            a[i] = 0.f;
+            auto const cov = canvas::quantize(std::abs(sum));
+            if (cov != run_cov) {
+                if (run_cov != 0)
+                    c.span(y, x + run_start, x + std::min(i, width), run_cov);
+                run_start = i;
+                run_cov = cov;
+            }
+        }
+        if (run_cov != 0)
+            c.span(y, x + run_start, x + std::min(hi + 1, width), run_cov);
+    }
+};
+
+constexpr float curve_tolerance = 0.125f;
+
+// enough segments to keep the polygon within curve_tolerance of the true curve
+std::size_t ellipse_segments(xy<float> const radii) noexcept {
+    auto const r = std::max(radii.x, radii.y);
+    if (r <= curve_tolerance)
+        return 8;
+    auto const step = 2.f * std::acos(1.f - curve_tolerance / r);
+    return std::clamp(static_cast<std::size_t>(std::ceil(2.f * std::numbers::pi_v<float> / step)), std::size_t{8}, std::size_t{4096});
+}
+
+void ellipse_contour(std::vector<point<float>>& out, point<float> const& center, xy<float> const radii, bool const reversed) {
+    auto const n = ellipse_segments(radii);
+    auto const step = 2.f * std::numbers::pi_v<float> / static_cast<float>(n);
+    // push the vertices out so the polygon has the same area as the curve instead of sitting inside it
+    auto const grow = std::sqrt(step / std::sin(step));
+    auto const rx = radii.x * grow, ry = radii.y * grow;
+    auto const dir = reversed ? -step : step;
+    out.clear();
+    out.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        auto const t = dir * static_cast<float>(i);
+        out.emplace_back(center.x() + rx * std::cos(t), center.y() + ry * std::sin(t));
+    }
+}
+
+bool valid_target(surface const& s) noexcept {
+    return s && s.width() > 0 && s.height() > 0;
+}
+
+} // namespace
+
+bool sdl2::draw_line(surface& s, point<float> const& from, point<float> const& to, rgba<> const color) noexcept {
+    if (!valid_target(s))
+        return false;
+    canvas c{s, color};
+    if (!c.ok())
+        return false;
+
+    // Wu's algorithm treats integer coordinates as pixel centers
+    auto x0 = from.x() - 0.5f, y0 = from.y() - 0.5f;
+    auto x1 = to.x() - 0.5f, y1 = to.y() - 0.5f;
+    if (!std::isfinite(x0) || !std::isfinite(y0) || !std::isfinite(x1) || !std::isfinite(y1))
+        return true;
+
+    auto const steep = std::abs(y1 - y0) > std::abs(x1 - x0);
+    if (steep) {
+        std::swap(x0, y0);
+        std::swap(x1, y1);
+    }
+    if (x0 > x1) {
+        std::swap(x0, x1);
+        std::swap(y0, y1);
+    }
+
+    auto const plot = [&c, steep](long long const x, long long const y, float const cov) {
+        if (steep)
+            c.plot(y, x, cov);
+        else
+            c.plot(x, y, cov);
+    };
+    auto const fpart = [](float const v) { return v - std::floor(v); };
+    auto const rfpart = [&fpart](float const v) { return 1.f - fpart(v); };
+
+    auto const& clip = c.clip();
+    auto const major_lo = static_cast<float>(steep ? clip.y() : clip.x()) - 1.f;
+    auto const major_hi = static_cast<float>(steep ? clip.y() + clip.h() : clip.x() + clip.w());
+    if (x1 < major_lo || x0 > major_hi)
+        return true;
+
+    auto const dx = x1 - x0;
+    auto const gradient = dx == 0.f ? 1.f : (y1 - y0) / dx;
+
+    // trim ends that lie far outside so every pixel coordinate fits an integer
+    if (x0 < major_lo - 1.f) {
+        y0 += gradient * (major_lo - 1.f - x0);
+        x0 = major_lo - 1.f;
+    }
+    if (x1 > major_hi + 1.f) {
+        y1 -= gradient * (x1 - major_hi - 1.f);
+        x1 = major_hi + 1.f;
+    }
+    auto const ipart = [](float const v) {
+        return static_cast<long long>(std::clamp(std::floor(v), -1e12f, 1e12f));
+    };
+
+    auto xend = std::round(x0);
+    auto yend = y0 + gradient * (xend - x0);
+    auto xgap = rfpart(x0 + 0.5f);
+    auto const xpxl1 = ipart(xend);
+    plot(xpxl1, ipart(yend), rfpart(yend) * xgap);
+    plot(xpxl1, ipart(yend) + 1, fpart(yend) * xgap);
+    auto const intery0 = yend + gradient;
+
+    xend = std::round(x1);
+    yend = y1 + gradient * (xend - x1);
+    xgap = fpart(x1 + 0.5f);
+    auto const xpxl2 = ipart(xend);
+    if (xpxl2 != xpxl1) {
+        plot(xpxl2, ipart(yend), rfpart(yend) * xgap);
+        plot(xpxl2, ipart(yend) + 1, fpart(yend) * xgap);
+    }
+
+    // only walk the part of the major axis that can land inside the clip rect
+    auto const first = std::max(xpxl1 + 1, static_cast<long long>(major_lo));
+    auto const last = std::min(xpxl2 - 1, static_cast<long long>(major_hi));
+    auto intery = intery0 + gradient * static_cast<float>(first - (xpxl1 + 1));
+    for (auto x = first; x <= last; ++x, intery += gradient) {
+        auto const yi = ipart(intery);
+        plot(x, yi, rfpart(intery));
+        plot(x, yi + 1, fpart(intery));
+    }
+    return true;
+}
+
+bool sdl2::draw_polyline(surface& s, std::span<point<float> const> const points, float const thickness, rgba<> const color) {
+    if (!valid_target(s))
+        return false;
+    if (thickness <= 1.f) {
+        for (std::size_t i = 1; i < points.size(); ++i) {
+            if (!draw_line(s, points[i - 1], points[i], color))
+                return false;
+        }
+        return true;
+    }
+
+    canvas c{s, color};
+    if (!c.ok())
+        return false;
+
+    // every segment quad and join is wound the same way so overlaps add up instead of cancelling,
+    // and a single fill pass means translucent strokes never blend twice where pieces overlap
+    edge_list edges{c.clip()};
+    auto const half = thickness * 0.5f;
+    std::vector<point<float>> join;
+    ellipse_contour(join, {0.f, 0.f}, {half, half}, false);
+    std::vector<point<float>> moved(join.size());
+
+    for (std::size_t i = 1; i < points.size(); ++i) {
+        auto const& p = points[i - 1];
+        auto const& q = points[i];
+        auto const dx = q.x() - p.x(), dy = q.y() - p.y();
+        auto const len = std::hypot(dx, dy);
+        if (len == 0.f || !std::isfinite(len))
+            continue;
+        auto const nx = -dy / len * half, ny = dx / len * half;
+        point<float> const quad[] = {
+            {p.x() - nx, p.y() - ny}, {q.x() - nx, q.y() - ny},
+            {q.x() + nx, q.y() + ny}, {p.x() + nx, p.y() + ny},
+        };
+        edges.add_contour(quad);
+
+        if (i + 1 < points.size()) {
+            std::transform(join.begin(), join.end(), moved.begin(),
+                           [&q](point<float> const& j) { return point<float>{j.x() + q.x(), j.y() + q.y()}; });
+            edges.add_contour(moved);
+        }
+    }
+    edges.fill(c);
+    return true;
+}
+
+bool sdl2::fill_polygon(surface& s, std::span<point<float> const> const points, rgba<> const color) {
+    if (!valid_target(s))
+        return false;
+    canvas c{s, color};
+    if (!c.ok())
+        return false;
+    edge_list edges{c.clip()};
+    edges.add_contour(points);
+    edges.fill(c);
+    return true;
+}
+
+bool sdl2::fill_circle(surface& s, point<float> const& center, float const radius, rgba<> const color) {
+    return fill_ellipse(s, center, {radius, radius}, color);
+}
+
+bool sdl2::draw_circle(surface& s, point<float> const& center, float const radius, float const thickness, rgba<> const color) {
+    return draw_ellipse(s, center, {radius, radius}, thickness, color);
+}
+
+bool sdl2::fill_ellipse(surface& s, point<float> const& center, xy<float> const radii, rgba<> const color) {
+    if (!valid_target(s))
+        return false;
+    canvas c{s, color};
+    if (!c.ok())
+        return false;
+    if (!(radii.x > 0.f && radii.y > 0.f))
+        return true;
+    std::vector<point<float>> contour;
+    ellipse_contour(contour, center, radii, false);
+    edge_list edges{c.clip()};
+    edges.add_contour(contour);
+    edges.fill(c);
+    return true;
+}
+
+bool sdl2::draw_ellipse(surface& s, point<float> const& center, xy<float> const radii, float const thickness, rgba<> const color) {
+    if (!valid_target(s))
+        return false;
+    canvas c{s, color};
+    if (!c.ok())
+        return false;
+    if (!(thickness > 0.f) || !(radii.x > 0.f && radii.y > 0.f))
+        return true;
+
+    // the outline is the outer ellipse with the inner one cut out by winding it the other way
+    auto const half = thickness * 0.5f;
+    std::vector<point<float>> contour;
+    edge_list edges{c.clip()};
+    ellipse_contour(contour, center, {radii.x + half, radii.y + half}, false);
+    edges.add_contour(contour);
+    if (radii.x > half && radii.y > half) {
+        ellipse_contour(contour, center, {radii.x - half, radii.y - half}, true);
+        edges.add_contour(contour);
+    }
+    edges.fill(c);
+    return true;
+}
@@ -0,0 +1,220 @@
+#include "sdl2pp/rect_batch.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SDL2PP_RECT_SSE2 1
+#endif
+
+using namespace sdl2;
+
+namespace {
+
+#ifdef SDL2PP_RECT_SSE2
+// A rect is four packed 32-bit lanes, so every kernel below processes one rect per register
+// in the "extent" form [x0, y0, x1, y1] where x1 = x + w and y1 = y + h.
+template<class T>
+struct lanes;
+
+template<>
+struct lanes<int> {
+    using reg = __m128i;
+
+    static reg load(void const* p) noexcept { return _mm_loadu_si128(static_cast<__m128i const*>(p)); }
+    static void store(void* p, reg v) noexcept { _mm_storeu_si128(static_cast<__m128i*>(p), v); }
+    static reg splat(int a, int b) noexcept { return _mm_set_epi32(b, a, b, a); }
+    static reg zero() noexcept { return _mm_setzero_si128(); }
+
+    static reg extent(reg v) noexcept {
+        auto const xyxy = _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 1, 0));
+        auto const wh = _mm_and_si128(v, _mm_set_epi32(-1, -1, 0, 0));
+        return _mm_add_epi32(xyxy, wh);
+    }
+    static reg to_xywh(reg e) noexcept { return _mm_sub_epi32(e, _mm_slli_si128(e, 8)); }
+
+    static reg gt(reg a, reg b) noexcept { return _mm_cmpgt_epi32(a, b); }
+    static reg select(reg m, reg a, reg b) noexcept { return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b)); }
+    static reg max(reg a, reg b) noexcept { return select(gt(a, b), a, b); }
+    static reg min(reg a, reg b) noexcept { return select(gt(a, b), b, a); }
+    static reg andnot(reg a, reg b) noexcept { return _mm_andnot_si128(a, b); }
+    static reg lo_hi(reg lo, reg hi) noexcept { return _mm_unpacklo_epi64(lo, _mm_unpackhi_epi64(hi, hi)); }
+    static int mask(reg m) noexcept { return _mm_movemask_ps(_mm_castsi128_ps(m)); }
+};
+
+template<>
+struct lanes<float> {
+    using reg = __m128;
+
+    static reg load(void const* p) noexcept { return _mm_loadu_ps(static_cast<float const*>(p)); }
+    static void store(void* p, reg v) noexcept { _mm_storeu_ps(static_cast<float*>(p), v); }
+    static reg splat(float a, float b) noexcept { return _mm_set_ps(b, a, b, a); }
+    static reg zero() noexcept { return _mm_setzero_ps(); }
+
+    static reg extent(reg v) noexcept {
+        auto const xyxy = _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 1, 0));
+        auto const wh = _mm_and_ps(v, _mm_castsi128_ps(_mm_set_epi32(-1, -1, 0, 0)));
+        return _mm_add_ps(xyxy, wh);
+    }
+    static reg to_xywh(reg e) noexcept {
+        return _mm_sub_ps(e, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(e), 8)));
+    }
+
+    static reg gt(reg a, reg b) noexcept { return _mm_cmpgt_ps(a, b); }
+    static reg max(reg a, reg b) noexcept { return _mm_max_ps(a, b); }
+    static reg min(reg a, reg b) noexcept { return _mm_min_ps(a, b); }
+    static reg andnot(reg a, reg b) noexcept { return _mm_andnot_ps(a, b); }
+    static reg lo_hi(reg lo, reg hi) noexcept { return _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 2, 1, 0)); }
+    static int mask(reg m) noexcept { return _mm_movemask_ps(m); }
+};
+
+// clipped rect in [x, y, w, h] form; w and h are <= 0 when the rects do not overlap
+template<class T>
+typename lanes<T>::reg clip_one(typename lanes<T>::reg const r, typename lanes<T>::reg const clip_extent) noexcept {
+    using L = lanes<T>;
+    auto const e = L::extent(r);
+    return L::to_xywh(L::lo_hi(L::max(e, clip_extent), L::min(e, clip_extent)));
+}
+
+template<class T>
+bool non_empty(typename lanes<T>::reg const xywh) noexcept {
+    using L = lanes<T>;
+    return (L::mask(L::gt(xywh, L::zero())) & 0b1100) == 0b1100;
+}
+#endif
+
+template<class T>
+std::size_t intersect_rects_impl(std::span<rect<T> const> const rects, rect<T> const& clip, std::span<rect<T>> const out) noexcept {
+    SDL2_ASSERT(out.size() >= rects.size());
+    std::size_t count = 0;
+    std::size_t i = 0;
+#ifdef SDL2PP_RECT_SSE2
+    using L = lanes<T>;
+    if (!clip.empty()) {
+        auto const c = L::extent(L::load(clip.native_handle()));
+        for (; i < rects.size(); ++i) {
+            auto const res = clip_one<T>(L::load(rects[i].native_handle()), c);
+            auto const keep = non_empty<T>(res);
+            L::store(out[i].native_handle(), keep ? res : L::zero());
+            count += keep;
+        }
+    }
+#endif
+    for (; i < rects.size(); ++i) {
+        auto const res = rects[i].intersection(clip);
+        out[i] = res.value_or(rect<T>{});
+        count += res.has_value();
+    }
+    return count;
+}
+
+template<class T>
+std::size_t cull_rects_impl(std::span<rect<T> const> const rects, rect<T> const& area, std::span<std::uint32_t> const indices) noexcept {
+    SDL2_ASSERT(indices.size() >= rects.size());
+    std::size_t count = 0;
+    std::size_t i = 0;
+#ifdef SDL2PP_RECT_SSE2
+    using L = lanes<T>;
+    if (!area.empty()) {
+        auto const c = L::extent(L::load(area.native_handle()));
+        for (; i < rects.size(); ++i) {
+            // write unconditionally and advance only on a hit to keep the loop branch-free
+            indices[count] = static_cast<std::uint32_t>(i);
+            count += non_empty<T>(clip_one<T>(L::load(rects[i].native_handle()), c));
+        }
+        return count;
+    }
+#endif
+    for (; i < rects.size(); ++i)
+        if (rects[i].intersects(area))
+            indices[count++] = static_cast<std::uint32_t>(i);
+    return count;
+}
+
+template<class T>
+std::optional<std::size_t> hit_test_impl(std::span<rect<T> const> const rects, point<T> const& p) noexcept {
+#ifdef SDL2PP_RECT_SSE2
+    using L = lanes<T>;
+    auto const pv = L::splat(p.x(), p.y());
+    for (auto i = rects.size(); i-- > 0;) {
+        // inside when x0 <= px, y0 <= py, x1 > px and y1 > py
+        if (L::mask(L::gt(L::extent(L::load(rects[i].native_handle())), pv)) == 0b1100)
+            return i;
+    }
+#else
+    for (auto i = rects.size(); i-- > 0;)
+        if (rects[i].contains(p))
+            return i;
+#endif
+    return {};
+}
+
+template<class T>
+std::size_t contains_points_impl(rect<T> const& r, std::span<point<T> const> const points, std::span<bool> const inside) noexcept {
+    SDL2_ASSERT(inside.size() >= points.size());
+    std::size_t count = 0;
+    std::size_t i = 0;
+#ifdef SDL2PP_RECT_SSE2
+    using L = lanes<T>;
+    auto const lo = L::splat(r.x(), r.y());
+    auto const hi = L::splat(r.x() + r.w(), r.y() + r.h());
+    for (; i + 2 <= points.size(); i += 2) {
+        auto const pv = L::load(points[i].native_handle());
+        auto const m = L::mask(L::andnot(L::gt(lo, pv), L::gt(hi, pv)));
+        inside[i] = (m & 0b0011) == 0b0011;
+        inside[i + 1] = (m & 0b1100) == 0b1100;
+        count += inside[i] + inside[i + 1];
+    }
+#endif
+    for (; i < points.size(); ++i) {
+        inside[i] = r.contains(points[i]);
+        count += inside[i];
+    }
+    return count;
+}
+
+template<class T>
+std::optional<rect<T>> union_rects_impl(std::span<rect<T> const> const rects) noexcept {
+    std::optional<rect<T>> ret;
+    for (auto const& r : rects) {
+        if (r.empty())
+            continue;
+        ret = ret ? ret->united(r) : r;
+    }
+    return ret;
+}
+
+} // namespace
+
+std::size_t sdl2::intersect_rects(std::span<rect<int> const> const rects, rect<int> const& clip, std::span<rect<int>> const out) noexcept {
+    return intersect_rects_impl(rects, clip, out);
+}
+std::size_t sdl2::intersect_rects(std::span<rect<float> const> const rects, rect<float> const& clip, std::span<rect<float>> const out) noexcept {
+    return intersect_rects_impl(rects, clip, out);
+}
+
+std::size_t sdl2::cull_rects(std::span<rect<int> const> const rects, rect<int> const& area, std::span<std::uint32_t> const indices) noexcept {
+    return cull_rects_impl(rects, area, indices);
+}
+std::size_t sdl2::cull_rects(std::span<rect<float> const> const rects, rect<float> const& area, std::span<std::uint32_t> const indices) noexcept {
+    return cull_rects_impl(rects, area, indices);
+}
+
+std::optional<std::size_t> sdl2::hit_test(std::span<rect<int> const> const rects, point<int> const& p) noexcept {
+    return hit_test_impl(rects, p);
+}
+std::optional<std::size_t> sdl2::hit_test(std::span<rect<float> const> const rects, point<float> const& p) noexcept {
+    return hit_test_impl(rects, p);
+}
+
+std::size_t sdl2::contains_points(rect<int> const& r, std::span<point<int> const> const points, std::span<bool> const inside) noexcept {
+    return contains_points_impl(r, points, inside);
+}
+std::size_t sdl2::contains_points(rect<float> const& r, std::span<point<float> const> const points, std::span<bool> const inside) noexcept {
+    return contains_points_impl(r, points, inside);
+}
+
+std::optional<rect<int>> sdl2::union_rects(std::span<rect<int> const> const rects) noexcept {
+    return union_rects_impl(rects);
+}
+std::optional<rect<float>> sdl2::union_rects(std::span<rect<float> const> const rects) noexcept {
+    return union_rects_impl(rects);
+}
@@ -89,6 +89,15 @@ bool renderer::copy(texture const& txr) noexcept {
     return SDL_RenderCopy(renderer_, txr.native_handle(), nullptr, nullptr) == 0;
 }
 
+bool renderer::render_geometry(texture const& txr, std::span<SDL_Vertex const> const vertices, std::span<int const> const indices) noexcept {
+    return SDL_RenderGeometry(renderer_, txr.native_handle(), vertices.data(), static_cast<int>(vertices.size()),
+                              indices.empty() ? nullptr : indices.data(), static_cast<int>(indices.size())) == 0;
+}
+bool renderer::render_geometry(std::span<SDL_Vertex const> const vertices, std::span<int const> const indices) noexcept {
+    return SDL_RenderGeometry(renderer_, nullptr, vertices.data(), static_cast<int>(vertices.size()),
+                              indices.empty() ? nullptr : indices.data(), static_cast<int>(indices.size())) == 0;
+}
+
 bool renderer::copy_ex(rect<int> const& render_rect, texture const& txr, rect<int> const& txr_rect, double const angle, point<int> const& center, renderer_flip const flip) noexcept {
     return SDL_RenderCopyEx(renderer_, txr.native_handle(), txr_rect.native_handle(), render_rect.native_handle(), angle, center.native_handle(), static_cast<SDL_RendererFlip>(flip)) == 0;
 }
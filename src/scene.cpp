@@ -0,0 +1,200 @@
+#include "sdl2pp/scene.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+using namespace sdl2;
+
+namespace {
+
+constexpr int floor_div(int const a, int const b) noexcept {
+    return a / b - ((a % b != 0) && ((a < 0) != (b < 0)));
+}
+
+constexpr std::uint64_t cell_key(int const cx, int const cy) noexcept {
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(cx)) << 32) | static_cast<std::uint32_t>(cy);
+}
+
+constexpr point<int> pivot_of(scene_node const& n) noexcept {
+    return n.center.value_or(point<int>{n.dst.w() / 2, n.dst.h() / 2});
+}
+
+// world-space bounding box of a node, accounting for its rotation
+rect<int> bounds_of(scene_node const& n) noexcept {
+    if (n.angle == 0.0)
+        return n.dst;
+
+    auto const pivot = pivot_of(n);
+    auto const px = static_cast<double>(n.dst.x() + pivot.x());
+    auto const py = static_cast<double>(n.dst.y() + pivot.y());
+    auto const rad = n.angle * std::numbers::pi / 180.0;
+    auto const c = std::cos(rad), s = std::sin(rad);
+
+    double x0 = px, y0 = py, x1 = px, y1 = py;
+    for (auto const& [cx, cy] : {n.dst.top_left(), n.dst.top_right(), n.dst.bottom_left(), n.dst.bottom_right()}) {
+        auto const dx = cx - px, dy = cy - py;
+        auto const x = px + dx * c - dy * s;
+        auto const y = py + dx * s + dy * c;
+        x0 = std::min(x0, x);
+        y0 = std::min(y0, y);
+        x1 = std::max(x1, x);
+        y1 = std::max(y1, y);
+    }
+    auto const ix = static_cast<int>(std::floor(x0));
+    auto const iy = static_cast<int>(std::floor(y0));
+    return {ix, iy, static_cast<int>(std::ceil(x1)) - ix, static_cast<int>(std::ceil(y1)) - iy};
+}
+
+} // namespace
+
+scene::scene(int const cell_size)
+    : cell_size_{std::max(cell_size, 1)}
+{}
+
+template<class F>
+void scene::for_each_cell(rect<int> const& area, F&& f) const {
+    if (area.w() <= 0 || area.h() <= 0)
+        return;
+    auto const cx0 = floor_div(area.x(), cell_size_);
+    auto const cy0 = floor_div(area.y(), cell_size_);
+    auto const cx1 = floor_div(area.x() + area.w() - 1, cell_size_);
+    auto const cy1 = floor_div(area.y() + area.h() - 1, cell_size_);
+    for (auto cy = cy0; cy <= cy1; ++cy)
+        for (auto cx = cx0; cx <= cx1; ++cx)
+            f(cell_key(cx, cy));
+}
+
+void scene::link(node_id const id) {
+    for_each_cell(entries_[id].bounds, [this, id](std::uint64_t const key) {
+        cells_[key].push_back(id);
+    });
+}
+
+void scene::unlink(node_id const id) noexcept {
+    for_each_cell(entries_[id].bounds, [this, id](std::uint64_t const key) {
+        if (auto const it = cells_.find(key); it != cells_.end()) {
+            auto& ids = it->second;
+            if (auto const pos = std::find(ids.begin(), ids.end(), id); pos != ids.end()) {
+                *pos = ids.back();
+                ids.pop_back();
+            }
+            if (ids.empty())
+                cells_.erase(it);
+        }
+    });
+}
+
+scene::node_id scene::add(scene_node const& node) {
+    node_id id{};
+    if (!free_.empty()) {
+        id = free_.back();
+        free_.pop_back();
+    } else {
+        id = static_cast<node_id>(entries_.size());
+        entries_.emplace_back();
+    }
+
+    auto& e = entries_[id];
+    e.node = node;
+    e.bounds = bounds_of(node);
+    e.seq = next_seq_++;
+    e.alive = true;
+    link(id);
+    return id;
+}
+
+void scene::remove(node_id const id) {
+    SDL2_ASSERT(contains(id));
+    unlink(id);
+    entries_[id].alive = false;
+    entries_[id].node.txr = nullptr;
+    free_.push_back(id);
+}
+
+void scene::update(node_id const id, scene_node const& node) {
+    SDL2_ASSERT(contains(id));
+    auto& e = entries_[id];
+    auto const bounds = bounds_of(node);
+    auto const moved = bounds != e.bounds;
+    if (moved)
+        unlink(id);
+    e.node = node;
+    e.bounds = bounds;
+    if (moved)
+        link(id);
+}
+
+void scene::move(node_id const id, rect<int> const& dst) {
+    SDL2_ASSERT(contains(id));
+    auto node = entries_[id].node;
+    node.dst = dst;
+    update(id, node);
+}
+
+scene_node const& scene::node(node_id const id) const noexcept {
+    SDL2_ASSERT(contains(id));
+    return entries_[id].node;
+}
+
+bool scene::contains(node_id const id) const noexcept {
+    return id < entries_.size() && entries_[id].alive;
+}
+
+void scene::clear() noexcept {
+    entries_.clear();
+    free_.clear();
+    cells_.clear();
+}
+
+std::size_t scene::query(rect<int> const& area, std::vector<node_id>& out) const {
+    if (++stamp_ == 0) {
+        for (auto& e : entries_)
+            e.stamp = 0;
+        stamp_ = 1;
+    }
+
+    auto const first = out.size();
+    for_each_cell(area, [&](std::uint64_t const key) {
+        auto const it = cells_.find(key);
+        if (it == cells_.end())
+            return;
+        for (auto const id : it->second) {
+            auto& e = entries_[id];
+            if (e.stamp != stamp_ && e.bounds.intersects(area)) {
+                e.stamp = stamp_;
+                out.push_back(id);
+            }
+        }
+    });
+
+    std::sort(out.begin() + static_cast<std::ptrdiff_t>(first), out.end(), [this](node_id const a, node_id const b) {
+        auto const& ea = entries_[a];
+        auto const& eb = entries_[b];
+        return ea.node.layer != eb.node.layer ? ea.node.layer < eb.node.layer : ea.seq < eb.seq;
+    });
+    return out.size() - first;
+}
+
+bool scene::draw(renderer& r, xy<int> const camera) {
+    auto const vp = r.viewport();
+    visible_.clear();
+    query({camera.x, camera.y, vp.w(), vp.h()}, visible_);
+
+    bool ok = true;
+    for (auto const id : visible_) {
+        auto const& n = entries_[id].node;
+        if (n.txr == nullptr)
+            continue;
+
+        rect<int> const dst{n.dst.x() - camera.x, n.dst.y() - camera.y, n.dst.w(), n.dst.h()};
+        if (n.angle == 0.0 && n.flip == renderer_flip::NONE) {
+            ok &= n.src ? r.copy(dst, *n.txr, *n.src) : r.copy(dst, *n.txr);
+        } else {
+            auto const pivot = pivot_of(n);
+            ok &= n.src ? r.copy_ex(dst, *n.txr, *n.src, n.angle, pivot, n.flip)
+                        : r.copy_ex(dst, *n.txr, n.angle, pivot, n.flip);
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,239 @@
+#include "sdl2pp/soa.hpp"
+
+#include <cmath>
+#include <numbers>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SDL2PP_SOA_SSE2 1
+#endif
+
+using namespace sdl2;
+
+namespace {
+
+// The transform kernels are plain loops over restrict pointers, which GCC/Clang/MSVC vectorise
+// at the library's default optimisation level. Interleaving is done by hand since compilers
+// generally do not turn strided stores into shuffles.
+
+template<class T>
+constexpr T round_to(float const v) noexcept {
+    if constexpr (std::is_same_v<T, int>)
+        return static_cast<int>(v < 0.f ? v - 0.5f : v + 0.5f);
+    else
+        return v;
+}
+
+template<class T>
+void translate_kernel(T* __restrict p, std::size_t const n, T const d) noexcept {
+    for (std::size_t i = 0; i < n; ++i)
+        p[i] += d;
+}
+
+template<class T>
+void scale_kernel(T* __restrict p, std::size_t const n, float const f, T const origin) noexcept {
+    auto const o = static_cast<float>(origin);
+    for (std::size_t i = 0; i < n; ++i)
+        p[i] = round_to<T>(o + (static_cast<float>(p[i]) - o) * f);
+}
+
+template<class T>
+void rotate_kernel(T* __restrict x, T* __restrict y, std::size_t const n,
+                   float const c, float const s, float const ox, float const oy) noexcept {
+    for (std::size_t i = 0; i < n; ++i) {
+        auto const dx = static_cast<float>(x[i]) - ox;
+        auto const dy = static_cast<float>(y[i]) - oy;
+        x[i] = round_to<T>(ox + dx * c - dy * s);
+        y[i] = round_to<T>(oy + dx * s + dy * c);
+    }
+}
+
+// rects rotate about their centers, so offset by half the size going in and out
+template<class T>
+void rotate_rects_kernel(T* __restrict x, T* __restrict y, T const* __restrict w, T const* __restrict h, std::size_t const n,
+                         float const c, float const s, float const ox, float const oy) noexcept {
+    for (std::size_t i = 0; i < n; ++i) {
+        auto const hw = static_cast<float>(w[i]) * 0.5f;
+        auto const hh = static_cast<float>(h[i]) * 0.5f;
+        auto const dx = static_cast<float>(x[i]) + hw - ox;
+        auto const dy = static_cast<float>(y[i]) + hh - oy;
+        x[i] = round_to<T>(ox + dx * c - dy * s - hw);
+        y[i] = round_to<T>(oy + dx * s + dy * c - hh);
+    }
+}
+
+// int and float are both 32-bit lanes; the shuffles below only move bits so one path serves both
+static_assert(sizeof(int) == sizeof(float));
+
+template<class T>
+void interleave2(T const* __restrict x, T const* __restrict y, T* __restrict out, std::size_t const n) noexcept {
+    std::size_t i = 0;
+#ifdef SDL2PP_SOA_SSE2
+    auto const fx = reinterpret_cast<float const*>(x);
+    auto const fy = reinterpret_cast<float const*>(y);
+    auto const fo = reinterpret_cast<float*>(out);
+    for (; i + 4 <= n; i += 4) {
+        auto const xv = _mm_loadu_ps(fx + i);
+        auto const yv = _mm_loadu_ps(fy + i);
+        _mm_storeu_ps(fo + 2 * i, _mm_unpacklo_ps(xv, yv));
+        _mm_storeu_ps(fo + 2 * i + 4, _mm_unpackhi_ps(xv, yv));
+    }
+#endif
+    for (; i < n; ++i) {
+        out[2 * i] = x[i];
+        out[2 * i + 1] = y[i];
+    }
+}
+
+template<class T>
+void deinterleave2(T const* __restrict in, T* __restrict x, T* __restrict y, std::size_t const n) noexcept {
+    std::size_t i = 0;
+#ifdef SDL2PP_SOA_SSE2
+    auto const fi = reinterpret_cast<float const*>(in);
+    auto const fx = reinterpret_cast<float*>(x);
+    auto const fy = reinterpret_cast<float*>(y);
+    for (; i + 4 <= n; i += 4) {
+        auto const a = _mm_loadu_ps(fi + 2 * i);
+        auto const b = _mm_loadu_ps(fi + 2 * i + 4);
+        _mm_storeu_ps(fx + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(fy + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+#endif
+    for (; i < n; ++i) {
+        x[i] = in[2 * i];
+        y[i] = in[2 * i + 1];
+    }
+}
+
+template<class T>
+void interleave4(T const* __restrict a, T const* __restrict b, T const* __restrict c, T const* __restrict d,
+                 T* __restrict out, std::size_t const n) noexcept {
+    std::size_t i = 0;
+#ifdef SDL2PP_SOA_SSE2
+    auto const fo = reinterpret_cast<float*>(out);
+    for (; i + 4 <= n; i += 4) {
+        auto r0 = _mm_loadu_ps(reinterpret_cast<float const*>(a + i));
+        auto r1 = _mm_loadu_ps(reinterpret_cast<float const*>(b + i));
+        auto r2 = _mm_loadu_ps(reinterpret_cast<float const*>(c + i));
+        auto r3 = _mm_loadu_ps(reinterpret_cast<float const*>(d + i));
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        _mm_storeu_ps(fo + 4 * i, r0);
+        _mm_storeu_ps(fo + 4 * i + 4, r1);
+        _mm_storeu_ps(fo + 4 * i + 8, r2);
+        _mm_storeu_ps(fo + 4 * i + 12, r3);
+    }
+#endif
+    for (; i < n; ++i) {
+        out[4 * i] = a[i];
+        out[4 * i + 1] = b[i];
+        out[4 * i + 2] = c[i];
+        out[4 * i + 3] = d[i];
+    }
+}
+
+template<class T>
+void deinterleave4(T const* __restrict in, T* __restrict a, T* __restrict b, T* __restrict c, T* __restrict d,
+                   std::size_t const n) noexcept {
+    std::size_t i = 0;
+#ifdef SDL2PP_SOA_SSE2
+    auto const fi = reinterpret_cast<float const*>(in);
+    for (; i + 4 <= n; i += 4) {
+        auto r0 = _mm_loadu_ps(fi + 4 * i);
+        auto r1 = _mm_loadu_ps(fi + 4 * i + 4);
+        auto r2 = _mm_loadu_ps(fi + 4 * i + 8);
+        auto r3 = _mm_loadu_ps(fi + 4 * i + 12);
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        _mm_storeu_ps(reinterpret_cast<float*>(a + i), r0);
+        _mm_storeu_ps(reinterpret_cast<float*>(b + i), r1);
+        _mm_storeu_ps(reinterpret_cast<float*>(c + i), r2);
+        _mm_storeu_ps(reinterpret_cast<float*>(d + i), r3);
+    }
+#endif
+    for (; i < n; ++i) {
+        a[i] = in[4 * i];
+        b[i] = in[4 * i + 1];
+        c[i] = in[4 * i + 2];
+        d[i] = in[4 * i + 3];
+    }
+}
+
+xy<float> sin_cos(double const degrees) noexcept {
+    auto const rad = degrees * std::numbers::pi / 180.0;
+    return {static_cast<float>(std::sin(rad)), static_cast<float>(std::cos(rad))};
+}
+
+} // namespace
+
+// sdl2::soa_points
+template<sdl2_shape_rep T>
+void soa_points<T>::translate(xy<T> const d) noexcept {
+    translate_kernel(x_.data(), x_.size(), d.x);
+    translate_kernel(y_.data(), y_.size(), d.y);
+}
+
+template<sdl2_shape_rep T>
+void soa_points<T>::scale(xy<float> const factor, xy<T> const origin) noexcept {
+    scale_kernel(x_.data(), x_.size(), factor.x, origin.x);
+    scale_kernel(y_.data(), y_.size(), factor.y, origin.y);
+}
+
+template<sdl2_shape_rep T>
+void soa_points<T>::rotate(double const degrees, xy<T> const origin) noexcept {
+    auto const [s, c] = sin_cos(degrees);
+    rotate_kernel(x_.data(), y_.data(), x_.size(), c, s, static_cast<float>(origin.x), static_cast<float>(origin.y));
+}
+
+template<sdl2_shape_rep T>
+std::span<point<T> const> soa_points<T>::pack(std::vector<point<T>>& scratch) const {
+    static_assert(sizeof(point<T>) == 2 * sizeof(T));
+    scratch.resize(size());
+    interleave2(x_.data(), y_.data(), reinterpret_cast<T*>(scratch.data()), size());
+    return scratch;
+}
+
+template<sdl2_shape_rep T>
+void soa_points<T>::unpack(std::span<point<T> const> const points) {
+    resize(points.size());
+    deinterleave2(reinterpret_cast<T const*>(points.data()), x_.data(), y_.data(), points.size());
+}
+
+// sdl2::soa_rects
+template<sdl2_shape_rep T>
+void soa_rects<T>::translate(xy<T> const d) noexcept {
+    translate_kernel(x_.data(), x_.size(), d.x);
+    translate_kernel(y_.data(), y_.size(), d.y);
+}
+
+template<sdl2_shape_rep T>
+void soa_rects<T>::scale(xy<float> const factor, xy<T> const origin) noexcept {
+    scale_kernel(x_.data(), x_.size(), factor.x, origin.x);
+    scale_kernel(y_.data(), y_.size(), factor.y, origin.y);
+    scale_kernel(w_.data(), w_.size(), factor.x, T(0));
+    scale_kernel(h_.data(), h_.size(), factor.y, T(0));
+}
+
+template<sdl2_shape_rep T>
+void soa_rects<T>::rotate(double const degrees, xy<T> const origin) noexcept {
+    auto const [s, c] = sin_cos(degrees);
+    rotate_rects_kernel(x_.data(), y_.data(), w_.data(), h_.data(), x_.size(),
+                        c, s, static_cast<float>(origin.x), static_cast<float>(origin.y));
+}
+
+template<sdl2_shape_rep T>
+std::span<rect<T> const> soa_rects<T>::pack(std::vector<rect<T>>& scratch) const {
+    static_assert(sizeof(rect<T>) == 4 * sizeof(T));
+    scratch.resize(size());
+    interleave4(x_.data(), y_.data(), w_.data(), h_.data(), reinterpret_cast<T*>(scratch.data()), size());
+    return scratch;
+}
+
+template<sdl2_shape_rep T>
+void soa_rects<T>::unpack(std::span<rect<T> const> const rects) {
+    resize(rects.size());
+    deinterleave4(reinterpret_cast<T const*>(rects.data()), x_.data(), y_.data(), w_.data(), h_.data(), rects.size());
+}
+
+template class sdl2::soa_points<int>;
+template class sdl2::soa_points<float>;
+template class sdl2::soa_rects<int>;
+template class sdl2::soa_rects<float>;
@@ -0,0 +1,264 @@
+#include "sdl2pp/span_sprite.hpp"
+#include "sdl2pp/surface.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <limits>
+
+#include "pixel_access.hpp"
+
+using namespace sdl2;
+
+namespace {
+
+// "SSPR", then the version, width, height, run count and pixel count
+constexpr std::uint32_t magic = 0x52505353;
+constexpr std::uint32_t version = 1;
+
+// where the bytes of an ARGB8888 value held in a std::uint32_t sit in memory
+constexpr detail::byte_layout argb_layout = std::endian::native == std::endian::little
+    ? detail::byte_layout{4, 2, 1, 0, 3}
+    : detail::byte_layout{4, 1, 2, 3, 0};
+
+void put(std::vector<std::byte>& out, std::uint32_t const v, int const bytes) {
+    for (int i = 0; i < bytes; ++i)
+        out.push_back(static_cast<std::byte>(v >> (8 * i)));
+}
+
+class reader {
+    std::span<std::byte const> data_;
+    std::size_t pos_ = 0;
+
+public:
+    explicit reader(std::span<std::byte const> const data) noexcept : data_{data} {}
+
+    bool get(std::uint32_t& v, int const bytes) noexcept {
+        if (data_.size() - pos_ < static_cast<std::size_t>(bytes))
+            return false;
+        v = 0;
+        for (int i = 0; i < bytes; ++i)
+            v |= static_cast<std::uint32_t>(data_[pos_++]) << (8 * i);
+        return true;
+    }
+
+    std::size_t remaining() const noexcept { return data_.size() - pos_; }
+};
+
+enum class coverage { transparent, translucent, opaque };
+
+} // namespace
+
+span_sprite::span_sprite(surface const& src) {
+    if (!src || src.width() <= 0 || src.height() <= 0 || src.width() > std::numeric_limits<std::uint16_t>::max())
+        return;
+
+    auto argb = src.convert_to_new(sdl2::pixel_format{pixel_format_enum::ARGB8888});
+    if (!argb)
+        return;
+
+    // the key is matched against the original pixels since converting to a format with alpha may or may not apply it
+    auto const key = src.color_key();
+    auto const bytes = src.pixel_format().bytes_per_pixel();
+    auto const color_mask = ~src.pixel_format().amask();
+
+    detail::surface_lock_guard const src_lock{const_cast<surface&>(src)};
+    detail::surface_lock_guard const argb_lock{argb};
+    if (src.pixels() == nullptr || argb.pixels() == nullptr)
+        return;
+
+    row_start_.reserve(static_cast<std::size_t>(src.height()) + 1);
+    for (int y = 0; y < src.height(); ++y) {
+        row_start_.push_back(static_cast<std::uint32_t>(runs_.size()));
+        auto const* const s = detail::pixel_at(src, 0, y);
+        auto const* const p = reinterpret_cast<std::uint32_t const*>(detail::pixel_at(std::as_const(argb), 0, y));
+        auto const classify = [&](int const x) {
+            if (key && (detail::load_pixel(s + x * bytes, bytes) & color_mask) == (key->value() & color_mask))
+                return coverage::transparent;
+            auto const a = p[x] >> 24;
+            return a == 0 ? coverage::transparent : a == 255 ? coverage::opaque : coverage::translucent;
+        };
+
+        for (int x = 0; x < src.width();) {
+            auto const kind = classify(x);
+            auto end = x + 1;
+            while (end < src.width() && classify(end) == kind)
+                ++end;
+            if (kind != coverage::transparent) {
+                runs_.push_back({static_cast<std::uint32_t>(pixels_.size()), static_cast<std::uint16_t>(x), static_cast<std::uint16_t>(end - x), kind == coverage::opaque});
+                pixels_.insert(pixels_.end(), p + x, p + end);
+            }
+            x = end;
+        }
+    }
+    row_start_.push_back(static_cast<std::uint32_t>(runs_.size()));
+    size_ = {src.width(), src.height()};
+    valid_ = true;
+}
+
+span_sprite::span_sprite(std::span<std::byte const> const data) {
+    valid_ = parse(data);
+}
+
+span_sprite::span_sprite(null_term_string const file) {
+    auto* const rw = SDL_RWFromFile(file.data(), "rb");
+    if (rw == nullptr)
+        return;
+    auto const size = SDL_RWsize(rw);
+    std::vector<std::byte> data(size > 0 ? static_cast<std::size_t>(size) : 0);
+    auto const read = !data.empty() && SDL_RWread(rw, data.data(), data.size(), 1) == 1;
+    SDL_RWclose(rw);
+    if (read)
+        valid_ = parse(data);
+}
+
+bool span_sprite::parse(std::span<std::byte const> const data) {
+    reader in{data};
+    std::uint32_t tag{}, ver{}, width{}, height{}, run_count{}, pixel_count{};
+    if (!in.get(tag, 4) || !in.get(ver, 4) || !in.get(width, 4) || !in.get(height, 4) || !in.get(run_count, 4) || !in.get(pixel_count, 4))
+        return false;
+    if (tag != magic || ver != version || width == 0 || height == 0 || width > std::numeric_limits<std::uint16_t>::max() ||
+        height > static_cast<std::uint32_t>(std::numeric_limits<int>::max()))
+        return false;
+
+    // check the sizes add up before allocating anything
+    auto const expected = 4ull * height + 5ull * run_count + 4ull * pixel_count;
+    if (in.remaining() != expected)
+        return false;
+
+    std::vector<std::uint32_t> row_start;
+    std::vector<run> runs;
+    std::vector<std::uint32_t> pixels;
+    row_start.reserve(height + 1ull);
+    runs.reserve(run_count);
+    pixels.resize(pixel_count);
+
+    std::vector<std::uint32_t> per_row(height);
+    for (auto& n : per_row)
+        in.get(n, 4);
+
+    std::uint64_t offset = 0;
+    for (auto const n : per_row) {
+        row_start.push_back(static_cast<std::uint32_t>(runs.size()));
+        if (n > run_count - runs.size())
+            return false;
+        std::uint32_t end = 0;
+        for (std::uint32_t i = 0; i < n; ++i) {
+            std::uint32_t x{}, length{}, opaque{};
+            in.get(x, 2);
+            in.get(length, 2);
+            in.get(opaque, 1);
+            // runs are non-empty, in order, inside the row and do not overlap
+            if (length == 0 || x < end || x + length > width || opaque > 1)
+                return false;
+            runs.push_back({static_cast<std::uint32_t>(offset), static_cast<std::uint16_t>(x), static_cast<std::uint16_t>(length), opaque == 1});
+            offset += length;
+            end = x + length;
+        }
+    }
+    if (runs.size() != run_count || offset != pixel_count)
+        return false;
+    row_start.push_back(run_count);
+
+    for (auto& p : pixels)
+        in.get(p, 4);
+
+    size_ = {static_cast<int>(width), static_cast<int>(height)};
+    row_start_ = std::move(row_start);
+    runs_ = std::move(runs);
+    pixels_ = std::move(pixels);
+    return true;
+}
+
+std::vector<std::byte> span_sprite::serialize() const {
+    std::vector<std::byte> out;
+    if (!valid_)
+        return out;
+
+    out.reserve(24 + 4 * static_cast<std::size_t>(size_.height) + 5 * runs_.size() + 4 * pixels_.size());
+    for (auto const v : {magic, version, static_cast<std::uint32_t>(size_.width), static_cast<std::uint32_t>(size_.height),
+                         static_cast<std::uint32_t>(runs_.size()), static_cast<std::uint32_t>(pixels_.size())})
+        put(out, v, 4);
+    for (int y = 0; y < size_.height; ++y)
+        put(out, row_start_[y + 1] - row_start_[y], 4);
+    for (auto const& r : runs_) {
+        put(out, r.x, 2);
+        put(out, r.length, 2);
+        put(out, r.opaque ? 1 : 0, 1);
+    }
+    for (auto const p : pixels_)
+        put(out, p, 4);
+    return out;
+}
+
+bool span_sprite::save(null_term_string const file) const {
+    auto const data = serialize();
+    if (data.empty())
+        return false;
+    auto* const rw = SDL_RWFromFile(file.data(), "wb");
+    if (rw == nullptr)
+        return false;
+    auto const wrote = SDL_RWwrite(rw, data.data(), data.size(), 1) == 1;
+    return SDL_RWclose(rw) == 0 && wrote;
+}
+
+bool span_sprite::blit(surface& dst, point<int> const at) const noexcept {
+    if (!valid_ || !dst)
+        return false;
+    auto const dl = detail::get_byte_layout(dst.pixel_format());
+    if (!dl || dl->bytes != 4)
+        return false;
+
+    auto const clip = rect<int>{at.x(), at.y(), size_.width, size_.height}.intersection(dst.clip_rect());
+    if (!clip)
+        return true;
+
+    detail::surface_lock_guard const lock{dst};
+    if (dst.pixels() == nullptr)
+        return false;
+
+    // opaque runs are copied verbatim when dst stores color bytes where ARGB8888 does
+    auto const same_order = dl->r == argb_layout.r && dl->g == argb_layout.g && dl->b == argb_layout.b && (dl->a < 0 || dl->a == argb_layout.a);
+    auto const x0 = clip->x() - at.x(), x1 = x0 + clip->w();
+
+    for (int y = clip->y(); y < clip->y() + clip->h(); ++y) {
+        auto const row = static_cast<std::size_t>(y - at.y());
+        auto* const d = reinterpret_cast<std::uint8_t*>(detail::pixel_at(dst, 0, y));
+        for (auto i = row_start_[row]; i < row_start_[row + 1]; ++i) {
+            auto const& r = runs_[i];
+            if (r.x >= x1)
+                break;
+            auto const b = std::max<int>(r.x, x0), e = std::min<int>(r.x + r.length, x1);
+            if (b >= e)
+                continue;
+
+            auto const* const s = pixels_.data() + r.offset + (b - r.x);
+            auto* const o = d + 4 * (at.x() + b);
+            if (r.opaque && same_order) {
+                std::memcpy(o, s, 4 * static_cast<std::size_t>(e - b));
+                continue;
+            }
+            for (int x = 0; x < e - b; ++x) {
+                auto const p = s[x];
+                auto* const q = o + 4 * x;
+                auto const a = p >> 24;
+                auto const sr = static_cast<std::uint8_t>(p >> 16), sg = static_cast<std::uint8_t>(p >> 8), sb = static_cast<std::uint8_t>(p);
+                if (r.opaque) {
+                    q[dl->r] = sr;
+                    q[dl->g] = sg;
+                    q[dl->b] = sb;
+                    if (dl->a >= 0)
+                        q[dl->a] = 0xFF;
+                    continue;
+                }
+                // SDL_BLENDMODE_BLEND: color lerps by source alpha, alpha becomes a + da * (1 - a)
+                q[dl->r] = detail::blend_channel(q[dl->r], sr, a);
+                q[dl->g] = detail::blend_channel(q[dl->g], sg, a);
+                q[dl->b] = detail::blend_channel(q[dl->b], sb, a);
+                if (dl->a >= 0)
+                    q[dl->a] = static_cast<std::uint8_t>(a + detail::div255(q[dl->a] * (255 - a)));
+            }
+        }
+    }
+    return true;
+}
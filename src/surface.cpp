@@ -2,6 +2,13 @@
 
 #include <SDL2/SDL_image.h>
 
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <limits>
+
+#include "pixel_access.hpp"
+
 using namespace sdl2;
 
 surface::surface(wh<int> const _wh, int const depth, rgba<std::uint32_t> const masks) noexcept 
@@ -21,42 +28,62 @@ surface::surface(void* const pixels, int const pitch, pixel_format_enum const fm
     : surface_{SDL_CreateRGBSurfaceWithFormatFrom(pixels, _wh.width, _wh.height, depth, pitch, static_cast<std::uint32_t>(fmt))}
 {}
 
-surface::surface(null_term_string const file) noexcept 
+surface::surface(pixel_format_enum const fmt, wh<int> const _wh, surface_alignment const align) noexcept
+    : surface_{nullptr}
+{
+    auto const f = static_cast<std::uint32_t>(fmt);
+    SDL2_ASSERT(std::has_single_bit(align.pixels) && (align.pitch == 0 || std::has_single_bit(align.pitch)));
+    // sub-byte formats (INDEX1, INDEX4) have no whole bytes per pixel to size a row with
+    if (_wh.width <= 0 || _wh.height <= 0 || SDL_ISPIXELFORMAT_FOURCC(f) || SDL_BYTESPERPIXEL(f) == 0)
+        return;
+
+    auto const row_align = std::max<std::size_t>(align.pitch, 4);
+    auto const row = static_cast<std::size_t>(_wh.width) * SDL_BYTESPERPIXEL(f);
+    auto const pitch = (row + row_align - 1) & ~(row_align - 1);
+    if (pitch > static_cast<std::size_t>(std::numeric_limits<int>::max()))
+        return;
+
+    auto const pixel_align = std::max(align.pixels, sizeof(void*));
+    auto* const block = static_cast<std::byte*>(SDL_malloc(pitch * static_cast<std::size_t>(_wh.height) + pixel_align));
+    if (!block)
+        return;
+    auto const addr = reinterpret_cast<std::uintptr_t>(block);
+    auto* const pixels = block + (((addr + pixel_align - 1) & ~(pixel_align - 1)) - addr);
+
+    // SDL_PREALLOC stays set, so SDL_FreeSurface leaves the buffer alone and ~surface releases it
+    surface_ = SDL_CreateRGBSurfaceWithFormatFrom(pixels, _wh.width, _wh.height, SDL_BITSPERPIXEL(f), static_cast<int>(pitch), f);
+    if (!surface_) {
+        SDL_free(block);
+        return;
+    }
+    owned_pixels_ = block;
+}
+
+surface::surface(null_term_string const file, alpha_format const alpha) noexcept 
     :surface_{IMG_Load(file.data())}
-{}
-
-constexpr surface::surface(surface&& other) noexcept 
-    : surface_(std::exchange(other.surface_, nullptr))
-{}
-
-surface::~surface() noexcept {
-    if (surface_)
+{
+    if (!surface_ || alpha != alpha_format::PREMULTIPLIED)
+        return;
+
+    auto const fmt = pixel_format();
+    auto const layout = detail::get_byte_layout(fmt);
+    if ((fmt.amask() != 0 || fmt.has_palette()) && !(layout && layout->bytes == 4 && layout->a >= 0)) {
+        auto* const converted = SDL_ConvertSurfaceFormat(surface_, SDL_PIXELFORMAT_ARGB8888, 0);
         SDL_FreeSurface(surface_);
+        surface_ = converted;
+    }
+    if (surface_)
+        premultiply_alpha();
 }
 
-constexpr const_pixel_format_view surface::pixel_format() const noexcept { 
-    SDL2_ASSERT(surface_->format != nullptr);
-    return {surface_->format}; 
-}
-
-constexpr int surface::width() const noexcept { return surface_->w; }
-constexpr int surface::height() const noexcept { return surface_->h; }
-constexpr int surface::pitch() const noexcept { return surface_->pitch; }
-constexpr void const* surface::pixels() const noexcept { return surface_->pixels; }
-constexpr void* surface::pixels() noexcept { return surface_->pixels; }
-constexpr int surface::num_pixels() const noexcept { return height() * pitch(); }
-constexpr void const* surface::userdata() const noexcept { return surface_->userdata; }
-constexpr void* surface::userdata() noexcept { return surface_->userdata; }
-constexpr void surface::set_userdata(void* const userdata) noexcept { surface_->userdata = userdata; }
-constexpr rect<int> surface::clip_rect() const noexcept { return surface_->clip_rect; }
-constexpr int surface::refcount() const noexcept { return surface_->refcount; }
-constexpr int surface::refcount_add(int const amt) noexcept { 
-    surface_->refcount += amt; 
-    return surface_->refcount; 
-}
-constexpr int surface::refcount_sub(int const amt) noexcept { 
-    surface_->refcount -= amt; 
-    return surface_->refcount; 
+surface::~surface() noexcept {
+    if (!surface_)
+        return;
+    auto const last = surface_->refcount <= 1;
+    SDL_FreeSurface(surface_);
+    // with references still held elsewhere the buffer must outlive this object, so it is left to leak
+    if (last && owned_pixels_)
+        SDL_free(owned_pixels_);
 }
 
 int surface::refcount_atomic_load(std::memory_order const order) const noexcept {
@@ -69,6 +96,11 @@ int surface::refcount_atomic_fetch_sub(int const amt, std::memory_order const or
     return std::atomic_ref{surface_->refcount}.fetch_sub(amt, order);
 }
 
+std::size_t surface::row_alignment() const noexcept {
+    auto const bits = reinterpret_cast<std::uintptr_t>(surface_->pixels) | static_cast<std::uintptr_t>(surface_->pitch) | 4096;
+    return std::size_t{1} << std::countr_zero(bits);
+}
+
 void surface::lock() noexcept { SDL_LockSurface(surface_); }
 void surface::unlock() noexcept { SDL_UnlockSurface(surface_); }
 bool surface::must_lock() const noexcept { return SDL_MUSTLOCK(surface_); }
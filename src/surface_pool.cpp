@@ -0,0 +1,120 @@
+#include "sdl2pp/surface_pool.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <new>
+#include <optional>
+
+using namespace sdl2;
+
+namespace {
+
+// buffers are cache line aligned so pooled rows start on the same boundary as SDL's own
+constexpr std::align_val_t buffer_alignment{64};
+constexpr unsigned min_size_class = 6;
+
+// the key packs the pixel format with the log2 of the buffer size
+constexpr std::uint64_t make_key(std::uint32_t const format, unsigned const size_class) noexcept {
+    return (static_cast<std::uint64_t>(format) << 8) | size_class;
+}
+
+constexpr std::size_t class_bytes(std::uint64_t const key) noexcept {
+    return std::size_t{1} << (key & 0xFF);
+}
+
+struct buffer_layout {
+    int pitch;
+    std::uint64_t key;
+};
+
+std::optional<buffer_layout> layout_for(pixel_format_enum const fmt, wh<int> const size) noexcept {
+    auto const f = static_cast<std::uint32_t>(fmt);
+    if (SDL_ISPIXELFORMAT_FOURCC(f) || size.width <= 0 || size.height <= 0)
+        return {};
+    // same row alignment SDL_CreateRGBSurfaceWithFormat uses
+    auto const row = static_cast<std::size_t>(size.width) * SDL_BYTESPERPIXEL(f);
+    auto const pitch = (row + 3) & ~std::size_t{3};
+    auto const bytes = pitch * static_cast<std::size_t>(size.height);
+    auto const size_class = std::max(min_size_class, static_cast<unsigned>(std::bit_width(bytes - 1)));
+    if (pitch > static_cast<std::size_t>(std::numeric_limits<int>::max()) || size_class >= sizeof(std::size_t) * 8)
+        return {};
+    return buffer_layout{static_cast<int>(pitch), make_key(f, size_class)};
+}
+
+} // namespace
+
+pooled_surface::~pooled_surface() noexcept {
+    if (!pool_)
+        return;
+    // free the SDL_Surface before its pixels can be handed to anyone else
+    { surface const released{std::move(surface_)}; }
+    pool_->release(buffer_, key_);
+}
+
+surface_pool::~surface_pool() noexcept {
+    SDL2_ASSERT(outstanding_ == 0);
+    trim();
+}
+
+std::byte* surface_pool::take(std::uint64_t const key) {
+    auto& b = buckets_[key];
+    if (!b.idle.empty()) {
+        auto* const buffer = b.idle.back();
+        b.idle.pop_back();
+        idle_bytes_ -= class_bytes(key);
+        return buffer;
+    }
+    // grow the free list with the number of live buffers so returning one never allocates
+    b.idle.reserve(b.allocated + 1);
+    auto* const buffer = static_cast<std::byte*>(::operator new(class_bytes(key), buffer_alignment));
+    ++b.allocated;
+    return buffer;
+}
+
+void surface_pool::release(std::byte* const buffer, std::uint64_t const key) noexcept {
+    --outstanding_;
+    auto const bytes = class_bytes(key);
+    auto& b = buckets_.find(key)->second;
+    if (idle_bytes_ + bytes > max_idle_bytes_ || b.idle.size() == b.idle.capacity()) {
+        ::operator delete(buffer, buffer_alignment);
+        --b.allocated;
+        return;
+    }
+    b.idle.push_back(buffer);
+    idle_bytes_ += bytes;
+}
+
+pooled_surface surface_pool::acquire(pixel_format_enum const fmt, wh<int> const size) {
+    auto const layout = layout_for(fmt, size);
+    if (!layout)
+        return {nullptr, nullptr, 0, surface{static_cast<SDL_Surface*>(nullptr)}};
+
+    auto* const buffer = take(layout->key);
+    ++outstanding_;
+    auto const depth = static_cast<int>(SDL_BITSPERPIXEL(static_cast<std::uint32_t>(fmt)));
+    return {this, buffer, layout->key, surface{buffer, layout->pitch, fmt, depth, size}};
+}
+
+void surface_pool::reserve(pixel_format_enum const fmt, wh<int> const size, std::size_t const count) {
+    auto const layout = layout_for(fmt, size);
+    if (!layout)
+        return;
+    auto& b = buckets_[layout->key];
+    b.idle.reserve(b.allocated + count);
+    for (std::size_t i = 0; i < count; ++i) {
+        b.idle.push_back(static_cast<std::byte*>(::operator new(class_bytes(layout->key), buffer_alignment)));
+        ++b.allocated;
+        idle_bytes_ += class_bytes(layout->key);
+    }
+}
+
+void surface_pool::trim() noexcept {
+    for (auto& [key, b] : buckets_) {
+        for (auto* const buffer : b.idle)
+            ::operator delete(buffer, buffer_alignment);
+        idle_bytes_ -= class_bytes(key) * b.idle.size();
+        b.allocated -= b.idle.size();
+        b.idle.clear();
+    }
+}
@@ -0,0 +1,236 @@
+#include "sdl2pp/surface_pyramid.hpp"
+#include "sdl2pp/renderer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+#include "parallel.hpp"
+#include "pixel_access.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SDL2PP_PYRAMID_SSE2 1
+#endif
+
+using namespace sdl2;
+
+namespace {
+
+// Averages 2x2 blocks of 4-byte pixels, byte by byte, rounding half up. An odd last column or row
+// is averaged with itself. The SSE2 loop produces four pixels per step from eight source pixels.
+void box_rows(surface const& src, surface& dst, int const begin, int const end) noexcept {
+    auto const sw = src.width(), sh = src.height(), dw = dst.width();
+    for (int y = begin; y < end; ++y) {
+        auto const* const r0 = detail::row_at(src, 2 * y);
+        auto const* const r1 = detail::row_at(src, std::min(2 * y + 1, sh - 1));
+        auto* const out = detail::row_at(dst, y);
+        int x = 0;
+#ifdef SDL2PP_PYRAMID_SSE2
+        auto const zero = _mm_setzero_si128(), two = _mm_set1_epi16(2);
+        auto const pairs = [zero](__m128i const a, __m128i const b, __m128i const c, __m128i const d) {
+            // a..d are two pixels each as 16-bit channels; returns the sums of the horizontal pairs (a, b) and (c, d)
+            return std::array{_mm_add_epi16(_mm_unpacklo_epi64(a, b), _mm_unpackhi_epi64(a, b)),
+                              _mm_add_epi16(_mm_unpacklo_epi64(c, d), _mm_unpackhi_epi64(c, d))};
+        };
+        for (; x + 4 <= dw && 2 * x + 8 <= sw; x += 4) {
+            auto const a0 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(r0 + 8 * x));
+            auto const a1 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(r0 + 8 * x + 16));
+            auto const b0 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(r1 + 8 * x));
+            auto const b1 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(r1 + 8 * x + 16));
+            auto const s0 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+            auto const s1 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+            auto const s2 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+            auto const s3 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+            auto const [h01, h23] = pairs(s0, s1, s2, s3);
+            auto const lo = _mm_srli_epi16(_mm_add_epi16(h01, two), 2);
+            auto const hi = _mm_srli_epi16(_mm_add_epi16(h23, two), 2);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4 * x), _mm_packus_epi16(lo, hi));
+        }
+#endif
+        for (; x < dw; ++x) {
+            auto const x0 = 4 * (2 * x), x1 = 4 * std::min(2 * x + 1, sw - 1);
+            for (int c = 0; c < 4; ++c)
+                out[4 * x + c] = static_cast<std::uint8_t>((r0[x0 + c] + r0[x1 + c] + r1[x0 + c] + r1[x1 + c] + 2) >> 2);
+        }
+    }
+}
+
+// A Kaiser-windowed sinc for 2:1 decimation, 8 taps wide. Output pixel x is centred on source pixel
+// 2x + 0.5, so tap k reads source pixel 2x - 3 + k.
+constexpr int kaiser_taps = 8;
+
+std::array<float, kaiser_taps> const& kaiser_weights() noexcept {
+    static auto const w = [] {
+        constexpr double beta = 4.0, pi = 3.14159265358979323846;
+        auto const bessel_i0 = [](double const x) {
+            double sum = 1, term = 1;
+            for (int k = 1; k < 32; ++k) {
+                term *= (x / (2 * k)) * (x / (2 * k));
+                sum += term;
+            }
+            return sum;
+        };
+        std::array<double, kaiser_taps> taps{};
+        double total = 0;
+        for (int k = 0; k < kaiser_taps; ++k) {
+            // distance from the centre in output pixels; the window spans two of them each way
+            auto const t = (k - 3.5) / 2.0;
+            auto const sinc = std::sin(pi * t) / (pi * t);
+            auto const u = t / 2.0;
+            taps[static_cast<std::size_t>(k)] = sinc * bessel_i0(beta * std::sqrt(1.0 - u * u)) / bessel_i0(beta);
+            total += taps[static_cast<std::size_t>(k)];
+        }
+        std::array<float, kaiser_taps> out{};
+        for (std::size_t k = 0; k < out.size(); ++k)
+            out[k] = static_cast<float>(taps[k] / total);
+        return out;
+    }();
+    return w;
+}
+
+// horizontal pass: every source row in [begin, end) to dw float pixels
+void kaiser_rows_h(surface const& src, float* const tmp, int const dw, int const begin, int const end) {
+    auto const& w = kaiser_weights();
+    auto const sw = src.width();
+    // source pixels with 3 clamped pixels before and 4 after, so the taps never need bounds checks
+    std::vector<float> padded(4 * static_cast<std::size_t>(2 * dw + kaiser_taps));
+    for (int y = begin; y < end; ++y) {
+        auto const* const r = detail::row_at(src, y);
+        for (int i = 0; i < 2 * dw + kaiser_taps; ++i) {
+            auto const sx = std::clamp(i - 3, 0, sw - 1);
+            for (int c = 0; c < 4; ++c)
+                padded[4 * static_cast<std::size_t>(i) + static_cast<std::size_t>(c)] = r[4 * sx + c];
+        }
+
+        auto* __restrict const out = tmp + 4 * static_cast<std::size_t>(y) * static_cast<std::size_t>(dw);
+        float const* __restrict const in = padded.data();
+        std::fill(out, out + 4 * static_cast<std::size_t>(dw), 0.0f);
+        for (int k = 0; k < kaiser_taps; ++k) {
+            auto const wk = w[static_cast<std::size_t>(k)];
+            // four channels of one pixel at a time, which the compiler turns into one 4-wide multiply-add
+            for (int x = 0; x < dw; ++x) {
+                for (int c = 0; c < 4; ++c)
+                    out[4 * x + c] += wk * in[8 * x + 4 * k + c];
+            }
+        }
+    }
+}
+
+// vertical pass: output rows [begin, end) from the horizontally filtered rows
+void kaiser_rows_v(float const* const tmp, int const sh, surface& dst, int const begin, int const end) {
+    auto const& w = kaiser_weights();
+    auto const n = 4 * static_cast<std::size_t>(dst.width());
+    std::vector<float> acc(n);
+    for (int y = begin; y < end; ++y) {
+        float* __restrict const sum = acc.data();
+        std::fill(sum, sum + n, 0.0f);
+        for (int k = 0; k < kaiser_taps; ++k) {
+            auto const sy = std::clamp(2 * y - 3 + k, 0, sh - 1);
+            float const* __restrict const in = tmp + static_cast<std::size_t>(sy) * n;
+            auto const wk = w[static_cast<std::size_t>(k)];
+            for (std::size_t i = 0; i < n; ++i)
+                sum[i] += wk * in[i];
+        }
+        auto* const out = detail::row_at(dst, y);
+        for (std::size_t i = 0; i < n; ++i)
+            out[i] = static_cast<std::uint8_t>(std::clamp(sum[i] + 0.5f, 0.0f, 255.0f));
+    }
+}
+
+bool downsample(surface& src, surface& dst, mip_filter const filter, std::size_t const threads, std::vector<float>& tmp) {
+    detail::surface_lock_guard const src_lock{src};
+    detail::surface_lock_guard const dst_lock{dst};
+    if (src.pixels() == nullptr || dst.pixels() == nullptr)
+        return false;
+
+    auto const row_pixels = static_cast<std::size_t>(dst.width());
+    if (filter == mip_filter::KAISER) {
+        tmp.resize(4 * row_pixels * static_cast<std::size_t>(src.height()));
+        detail::parallel_rows(src.height(), row_pixels, threads, [&](int const begin, int const end) {
+            kaiser_rows_h(src, tmp.data(), dst.width(), begin, end);
+        });
+        detail::parallel_rows(dst.height(), row_pixels, threads, [&](int const begin, int const end) {
+            kaiser_rows_v(tmp.data(), src.height(), dst, begin, end);
+        });
+    } else {
+        detail::parallel_rows(dst.height(), row_pixels, threads, [&](int const begin, int const end) {
+            box_rows(src, dst, begin, end);
+        });
+    }
+    return true;
+}
+
+} // namespace
+
+surface_pyramid::surface_pyramid(surface const& base, mip_filter const filter, std::size_t const max_levels, std::size_t const threads) {
+    if (!base || base.width() <= 0 || base.height() <= 0)
+        return;
+
+    auto const layout = detail::get_byte_layout(base.pixel_format());
+    auto const format = layout && layout->bytes == 4 ? base.pixel_format().format() : pixel_format_enum::ARGB8888;
+    auto first = base.convert_to_new(sdl2::pixel_format{format});
+    if (!first)
+        return;
+
+    auto const limit = max_levels == 0 ? std::size_t{64} : max_levels;
+    levels_.push_back(std::move(first));
+    std::vector<float> tmp;
+    while (levels_.size() < limit && (levels_.back().width() > 1 || levels_.back().height() > 1)) {
+        auto& src = levels_.back();
+        wh<int> const size{std::max(src.width() / 2, 1), std::max(src.height() / 2, 1)};
+        surface dst{format, size, surface_alignment{}};
+        if (!dst || !downsample(src, dst, filter, threads, tmp)) {
+            levels_.clear();
+            return;
+        }
+        levels_.push_back(std::move(dst));
+    }
+}
+
+std::size_t surface_pyramid::level_for(wh<int> const dst_size) const noexcept {
+    std::size_t level = 0;
+    while (level + 1 < levels_.size() && levels_[level + 1].width() >= dst_size.width && levels_[level + 1].height() >= dst_size.height)
+        ++level;
+    return level;
+}
+
+std::size_t surface_pyramid::level_for(rect<int> const& srcrect, rect<int> const& dstrect) const noexcept {
+    if (levels_.empty())
+        return 0;
+    // the part of level i drawn is srcrect scaled by the level's size over the base's
+    auto const bw = static_cast<std::int64_t>(levels_[0].width()), bh = static_cast<std::int64_t>(levels_[0].height());
+    std::size_t level = 0;
+    while (level + 1 < levels_.size()) {
+        auto const& next = levels_[level + 1];
+        if (srcrect.w() * static_cast<std::int64_t>(next.width()) < dstrect.w() * bw ||
+            srcrect.h() * static_cast<std::int64_t>(next.height()) < dstrect.h() * bh)
+            break;
+        ++level;
+    }
+    return level;
+}
+
+rect<int> surface_pyramid::level_rect(rect<int> const& srcrect, std::size_t const level) const noexcept {
+    if (level >= levels_.size())
+        return srcrect;
+    auto const scale = [](int const v, std::int64_t const num, std::int64_t const den, bool const up) {
+        auto const n = v * num;
+        auto const q = n / den, r = n % den;
+        return static_cast<int>(r == 0 ? q : up ? (n > 0 ? q + 1 : q) : (n < 0 ? q - 1 : q));
+    };
+    auto const bw = levels_[0].width(), bh = levels_[0].height();
+    auto const lw = levels_[level].width(), lh = levels_[level].height();
+    auto const x0 = scale(srcrect.x(), lw, bw, false), y0 = scale(srcrect.y(), lh, bh, false);
+    auto const x1 = scale(srcrect.x() + srcrect.w(), lw, bw, true), y1 = scale(srcrect.y() + srcrect.h(), lh, bh, true);
+    return {x0, y0, x1 - x0, y1 - y0};
+}
+
+std::vector<texture> surface_pyramid::make_textures(renderer& r, alpha_format const alpha) const {
+    std::vector<texture> out;
+    out.reserve(levels_.size());
+    for (auto const& level : levels_)
+        out.emplace_back(r, level, alpha);
+    return out;
+}
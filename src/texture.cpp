@@ -3,8 +3,83 @@
 
 #include <SDL2/SDL_image.h>
 
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SDL2PP_TEXTURE_SSE2 1
+#endif
+
 using namespace sdl2;
 
+namespace {
+
+// whether a plane of rows holding row_bytes each, pitch bytes apart, fits in a span
+constexpr bool plane_fits(std::size_t const span_bytes, int const pitch, int const row_bytes, int const rows) noexcept {
+    return pitch >= row_bytes && (rows == 0 || span_bytes >= static_cast<std::size_t>(pitch) * static_cast<std::size_t>(rows - 1) + static_cast<std::size_t>(row_bytes));
+}
+
+void split_row(std::uint8_t const* const uv, std::uint8_t* const a, std::uint8_t* const b, int const n) noexcept {
+    int x = 0;
+#ifdef SDL2PP_TEXTURE_SSE2
+    auto const low = _mm_set1_epi16(0x00FF);
+    for (; x + 16 <= n; x += 16) {
+        auto const p0 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(uv + 2 * x));
+        auto const p1 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(uv + 2 * x + 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(a + x), _mm_packus_epi16(_mm_and_si128(p0, low), _mm_and_si128(p1, low)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(b + x), _mm_packus_epi16(_mm_srli_epi16(p0, 8), _mm_srli_epi16(p1, 8)));
+    }
+#endif
+    for (; x < n; ++x) {
+        a[x] = uv[2 * x];
+        b[x] = uv[2 * x + 1];
+    }
+}
+
+void merge_row(std::uint8_t const* const a, std::uint8_t const* const b, std::uint8_t* const uv, int const n) noexcept {
+    int x = 0;
+#ifdef SDL2PP_TEXTURE_SSE2
+    for (; x + 16 <= n; x += 16) {
+        auto const va = _mm_loadu_si128(reinterpret_cast<__m128i const*>(a + x));
+        auto const vb = _mm_loadu_si128(reinterpret_cast<__m128i const*>(b + x));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(uv + 2 * x), _mm_unpacklo_epi8(va, vb));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(uv + 2 * x + 16), _mm_unpackhi_epi8(va, vb));
+    }
+#endif
+    for (; x < n; ++x) {
+        uv[2 * x] = a[x];
+        uv[2 * x + 1] = b[x];
+    }
+}
+
+// round(v / 256), saturated, keeps the 8 high bits of a 10-bit sample stored in the top of 16 bits
+void narrow_row(std::uint8_t const* const src, std::uint8_t* const dst, int const n) noexcept {
+    int x = 0;
+#ifdef SDL2PP_TEXTURE_SSE2
+    auto const half = _mm_set1_epi16(128);
+    for (; x + 16 <= n; x += 16) {
+        auto const p0 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + 2 * x));
+        auto const p1 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + 2 * x + 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x),
+                         _mm_packus_epi16(_mm_srli_epi16(_mm_adds_epu16(p0, half), 8), _mm_srli_epi16(_mm_adds_epu16(p1, half), 8)));
+    }
+#endif
+    for (; x < n; ++x) {
+        std::uint16_t v;
+        std::memcpy(&v, src + 2 * x, 2);
+        dst[x] = static_cast<std::uint8_t>(std::min(255, (v + 128) >> 8));
+    }
+}
+
+} // namespace
+
+sdl2::blend_mode sdl2::premultiplied_blend_mode() noexcept {
+    return static_cast<sdl2::blend_mode>(SDL_ComposeCustomBlendMode(
+        SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+        SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD));
+}
+
 texture::texture(renderer& r, pixel_format_enum const format, texture_access const access, wh<int> const wh) noexcept 
     : texture_{SDL_CreateTexture(r.native_handle(), static_cast<std::uint32_t>(format), static_cast<int>(access), wh.width, wh.height)} 
 {}
@@ -13,13 +88,23 @@ texture::texture(renderer& r, surface const& s) noexcept
     : texture_{SDL_CreateTextureFromSurface(r.native_handle(), s.native_handle())}
 {}
 
-texture::texture(renderer& r, null_term_string const file) noexcept 
-    : texture_{[&r, &file]() -> SDL_Texture* {
-        if (surface s{file}; s)
+texture::texture(renderer& r, surface const& s, alpha_format const alpha) noexcept 
+    : texture(r, s)
+{
+    if (texture_ && alpha == alpha_format::PREMULTIPLIED)
+        set_blend_mode(premultiplied_blend_mode());
+}
+
+texture::texture(renderer& r, null_term_string const file, alpha_format const alpha) noexcept 
+    : texture_{[&r, &file, alpha]() -> SDL_Texture* {
+        if (surface s{file, alpha}; s)
             return SDL_CreateTextureFromSurface(r.native_handle(), s.native_handle());
         return nullptr;
     }()}
-{}
+{
+    if (texture_ && alpha == alpha_format::PREMULTIPLIED)
+        set_blend_mode(premultiplied_blend_mode());
+}
 
 texture::~texture() noexcept { 
     if (texture_) 
@@ -135,4 +220,76 @@ bool texture::update_yuv(std::span<std::byte const> yplane, int const ypitch,
     return SDL_UpdateYUVTexture(texture_, nullptr, reinterpret_cast<std::uint8_t const*>(yplane.data()), ypitch, 
                                                    reinterpret_cast<std::uint8_t const*>(uplane.data()), upitch, 
                                                    reinterpret_cast<std::uint8_t const*>(vplane.data()), vpitch) == 0;
-}
\ No newline at end of file
+}
+
+bool texture::update_nv(rect<int> const& rect,
+                        std::span<std::byte const> yplane, int const ypitch,
+                        std::span<std::byte const> uvplane, int const uvpitch) noexcept
+{
+    return SDL_UpdateNVTexture(texture_, rect.native_handle(), reinterpret_cast<std::uint8_t const*>(yplane.data()), ypitch,
+                                                               reinterpret_cast<std::uint8_t const*>(uvplane.data()), uvpitch) == 0;
+}
+
+bool texture::update_nv(std::span<std::byte const> yplane, int const ypitch,
+                        std::span<std::byte const> uvplane, int const uvpitch) noexcept
+{
+    return SDL_UpdateNVTexture(texture_, nullptr, reinterpret_cast<std::uint8_t const*>(yplane.data()), ypitch,
+                                                  reinterpret_cast<std::uint8_t const*>(uvplane.data()), uvpitch) == 0;
+}
+
+bool sdl2::split_uv(wh<int> const size,
+                    std::span<std::byte const> const uv, int const uvpitch,
+                    std::span<std::byte> const first, int const first_pitch,
+                    std::span<std::byte> const second, int const second_pitch) noexcept
+{
+    if (size.width < 0 || size.height < 0
+        || !plane_fits(uv.size(), uvpitch, 2 * size.width, size.height)
+        || !plane_fits(first.size(), first_pitch, size.width, size.height)
+        || !plane_fits(second.size(), second_pitch, size.width, size.height))
+        return false;
+
+    for (int y = 0; y < size.height; ++y) {
+        split_row(reinterpret_cast<std::uint8_t const*>(uv.data()) + static_cast<std::ptrdiff_t>(y) * uvpitch,
+                  reinterpret_cast<std::uint8_t*>(first.data()) + static_cast<std::ptrdiff_t>(y) * first_pitch,
+                  reinterpret_cast<std::uint8_t*>(second.data()) + static_cast<std::ptrdiff_t>(y) * second_pitch,
+                  size.width);
+    }
+    return true;
+}
+
+bool sdl2::merge_uv(wh<int> const size,
+                    std::span<std::byte const> const first, int const first_pitch,
+                    std::span<std::byte const> const second, int const second_pitch,
+                    std::span<std::byte> const uv, int const uvpitch) noexcept
+{
+    if (size.width < 0 || size.height < 0
+        || !plane_fits(first.size(), first_pitch, size.width, size.height)
+        || !plane_fits(second.size(), second_pitch, size.width, size.height)
+        || !plane_fits(uv.size(), uvpitch, 2 * size.width, size.height))
+        return false;
+
+    for (int y = 0; y < size.height; ++y) {
+        merge_row(reinterpret_cast<std::uint8_t const*>(first.data()) + static_cast<std::ptrdiff_t>(y) * first_pitch,
+                  reinterpret_cast<std::uint8_t const*>(second.data()) + static_cast<std::ptrdiff_t>(y) * second_pitch,
+                  reinterpret_cast<std::uint8_t*>(uv.data()) + static_cast<std::ptrdiff_t>(y) * uvpitch,
+                  size.width);
+    }
+    return true;
+}
+
+bool sdl2::narrow_p010(wh<int> const size,
+                       std::span<std::byte const> const src, int const src_pitch,
+                       std::span<std::byte> const dst, int const dst_pitch) noexcept
+{
+    if (size.width < 0 || size.height < 0
+        || !plane_fits(src.size(), src_pitch, 2 * size.width, size.height)
+        || !plane_fits(dst.size(), dst_pitch, size.width, size.height))
+        return false;
+
+    for (int y = 0; y < size.height; ++y) {
+        narrow_row(reinterpret_cast<std::uint8_t const*>(src.data()) + static_cast<std::ptrdiff_t>(y) * src_pitch,
+                   reinterpret_cast<std::uint8_t*>(dst.data()) + static_cast<std::ptrdiff_t>(y) * dst_pitch,
+                   size.width);
+    }
+    return true;
+}
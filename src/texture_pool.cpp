@@ -0,0 +1,155 @@
+#include "sdl2pp/texture_pool.hpp"
+#include "sdl2pp/renderer.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+using namespace sdl2;
+
+namespace {
+
+// above any renderer's maximum texture size, and small enough that bucketed sizes fit the key
+constexpr int max_dim = 16384;
+
+// sizes round up to a quarter of their power of two (e.g. 100 -> 112, 1000 -> 1024), at least 16
+constexpr int bucket_dim(int const n) noexcept {
+    if (n <= 16)
+        return 16;
+    auto const step = std::max(16u, std::bit_floor(static_cast<unsigned>(n)) / 4);
+    return static_cast<int>((static_cast<unsigned>(n) + step - 1) / step * step);
+}
+
+constexpr std::uint64_t make_key(pixel_format_enum const format, texture_access const access, wh<int> const size) noexcept {
+    return (static_cast<std::uint64_t>(format) << 32)
+         | (static_cast<std::uint64_t>(access) & 0x3) << 30
+         | (static_cast<std::uint64_t>(size.width) & 0x7FFF) << 15
+         | (static_cast<std::uint64_t>(size.height) & 0x7FFF);
+}
+
+constexpr wh<int> key_size(std::uint64_t const key) noexcept {
+    return {static_cast<int>((key >> 15) & 0x7FFF), static_cast<int>(key & 0x7FFF)};
+}
+
+// an estimate of driver memory; planar YUV formats average 1.5 bytes per pixel
+std::size_t key_bytes(std::uint64_t const key) noexcept {
+    auto const format = static_cast<std::uint32_t>(key >> 32);
+    auto const [w, h] = key_size(key);
+    auto const pixels = static_cast<std::size_t>(w) * static_cast<std::size_t>(h);
+    if (SDL_ISPIXELFORMAT_FOURCC(format))
+        return pixels + pixels / 2;
+    return pixels * SDL_BYTESPERPIXEL(format);
+}
+
+// the state SDL_CreateTexture leaves a texture in: blending on for formats with alpha, off otherwise
+void reset_state(texture& t, std::uint64_t const key) noexcept {
+    t.set_blend_mode(is_pixel_format_alpha(static_cast<pixel_format_enum>(key >> 32)) ? blend_mode::BLEND : blend_mode::NONE);
+    t.set_alpha_mod(255);
+    t.set_color_mod({255, 255, 255});
+}
+
+} // namespace
+
+pooled_texture::~pooled_texture() noexcept {
+    if (pool_)
+        pool_->release(std::move(texture_), key_);
+}
+
+texture_pool::~texture_pool() noexcept {
+    SDL2_ASSERT(stats_.live_bytes == 0);
+    trim();
+}
+
+pooled_texture texture_pool::acquire(pixel_format_enum const format, texture_access const access, wh<int> const size) {
+    if (size.width <= 0 || size.height <= 0 || size.width > max_dim || size.height > max_dim)
+        return {nullptr, 0, size, texture{static_cast<SDL_Texture*>(nullptr)}};
+
+    auto const alloc = bucket_sizes_ ? wh<int>{bucket_dim(size.width), bucket_dim(size.height)} : size;
+    auto const key = make_key(format, access, alloc);
+    auto const bytes = key_bytes(key);
+    auto& b = buckets_[key];
+    b.last_used = ++clock_;
+
+    if (!b.idle.empty()) {
+        texture t{std::move(b.idle.back())};
+        b.idle.pop_back();
+        ++stats_.hits;
+        stats_.idle_bytes -= bytes;
+        stats_.live_bytes += bytes;
+        return {this, key, size, std::move(t)};
+    }
+
+    ++stats_.misses;
+    evict_for(bytes);
+    texture t{renderer_, format, access, alloc};
+    if (!t)
+        return {nullptr, key, size, std::move(t)};
+    ++stats_.created;
+    ++b.allocated;
+    // keep room to take every texture of this bucket back without reallocating
+    b.idle.reserve(b.allocated);
+    stats_.live_bytes += bytes;
+    return {this, key, size, std::move(t)};
+}
+
+void texture_pool::release(texture&& t, std::uint64_t const key) noexcept {
+    auto const bytes = key_bytes(key);
+    auto& b = buckets_.find(key)->second;
+    stats_.live_bytes -= bytes;
+    b.last_used = ++clock_;
+    if (stats_.live_bytes + stats_.idle_bytes + bytes > max_bytes_ || b.idle.size() == b.idle.capacity()) {
+        texture const destroyed{std::move(t)};
+        --b.allocated;
+        ++stats_.destroyed;
+        return;
+    }
+    reset_state(t, key);
+    b.idle.push_back(std::move(t));
+    stats_.idle_bytes += bytes;
+}
+
+void texture_pool::evict_for(std::size_t const bytes) noexcept {
+    // destroy idle textures from the least recently used buckets until the new one fits under the cap
+    while (stats_.live_bytes + stats_.idle_bytes + bytes > max_bytes_ && stats_.idle_bytes > 0) {
+        bucket* oldest = nullptr;
+        std::uint64_t oldest_key = 0;
+        for (auto& [key, b] : buckets_) {
+            if (!b.idle.empty() && (!oldest || b.last_used < oldest->last_used)) {
+                oldest = &b;
+                oldest_key = key;
+            }
+        }
+        { texture const destroyed{std::move(oldest->idle.back())}; }
+        oldest->idle.pop_back();
+        --oldest->allocated;
+        ++stats_.destroyed;
+        stats_.idle_bytes -= key_bytes(oldest_key);
+    }
+}
+
+void texture_pool::reserve(pixel_format_enum const format, texture_access const access, wh<int> const size, std::size_t const count) {
+    if (size.width <= 0 || size.height <= 0 || size.width > max_dim || size.height > max_dim)
+        return;
+    auto const alloc = bucket_sizes_ ? wh<int>{bucket_dim(size.width), bucket_dim(size.height)} : size;
+    auto const key = make_key(format, access, alloc);
+    auto& b = buckets_[key];
+    b.idle.reserve(b.allocated + count);
+    for (std::size_t i = 0; i < count; ++i) {
+        texture t{renderer_, format, access, alloc};
+        if (!t)
+            return;
+        ++stats_.created;
+        ++b.allocated;
+        b.idle.push_back(std::move(t));
+        stats_.idle_bytes += key_bytes(key);
+    }
+}
+
+void texture_pool::trim() noexcept {
+    for (auto& [key, b] : buckets_) {
+        stats_.destroyed += b.idle.size();
+        stats_.idle_bytes -= key_bytes(key) * b.idle.size();
+        b.allocated -= b.idle.size();
+        b.idle.clear();
+    }
+}
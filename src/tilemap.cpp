@@ -0,0 +1,179 @@
+#include "sdl2pp/tilemap.hpp"
+#include "sdl2pp/renderer.hpp"
+
+#include <algorithm>
+
+using namespace sdl2;
+
+namespace {
+
+constexpr int ceil_div(int const a, int const b) noexcept {
+    return (a + b - 1) / b;
+}
+
+// restores the render target, draw color and draw blend mode changed while rendering a chunk
+class render_state_guard {
+    renderer& r_;
+    SDL_Texture* target_;
+    rgba<> color_;
+    blend_mode blend_;
+
+public:
+    explicit render_state_guard(renderer& r) noexcept
+        : r_{r}
+        , target_{SDL_GetRenderTarget(r.native_handle())}
+        , color_{r.draw_color()}
+        , blend_{r.draw_blend_mode()} {}
+
+    render_state_guard(render_state_guard const&) = delete;
+    render_state_guard& operator=(render_state_guard const&) = delete;
+
+    ~render_state_guard() noexcept {
+        SDL_SetRenderTarget(r_.native_handle(), target_);
+        r_.set_draw_color(color_);
+        r_.set_draw_blend_mode(blend_);
+    }
+};
+
+} // namespace
+
+tilemap::tilemap(renderer& r, texture& tileset, wh<int> const tile_size, wh<int> const map_size, int const chunk_tiles, std::size_t const max_cached_chunks)
+    : renderer_{r}
+    , tileset_{tileset}
+    , tile_size_{tile_size}
+    , map_size_{std::max(map_size.width, 0), std::max(map_size.height, 0)}
+    , chunk_tiles_{std::max(chunk_tiles, 1)}
+    , chunks_size_{ceil_div(map_size_.width, chunk_tiles_), ceil_div(map_size_.height, chunk_tiles_)}
+    , tileset_columns_{std::max(tileset.size().width / std::max(tile_size.width, 1), 1)}
+    , max_cached_chunks_{max_cached_chunks}
+    , tiles_(static_cast<std::size_t>(map_size_.width) * static_cast<std::size_t>(map_size_.height), no_tile)
+    , chunks_(static_cast<std::size_t>(chunks_size_.width) * static_cast<std::size_t>(chunks_size_.height))
+{
+    SDL2_ASSERT(tile_size.width > 0 && tile_size.height > 0);
+    cached_.reserve(max_cached_chunks_);
+}
+
+tilemap::tile_id tilemap::tile(point<int> const cell) const noexcept {
+    SDL2_ASSERT(cell.x() >= 0 && cell.y() >= 0 && cell.x() < map_size_.width && cell.y() < map_size_.height);
+    return tiles_[static_cast<std::size_t>(cell.y()) * static_cast<std::size_t>(map_size_.width) + static_cast<std::size_t>(cell.x())];
+}
+
+void tilemap::set_tile(point<int> const cell, tile_id const id) noexcept {
+    if (cell.x() < 0 || cell.y() < 0 || cell.x() >= map_size_.width || cell.y() >= map_size_.height)
+        return;
+    auto& t = tiles_[static_cast<std::size_t>(cell.y()) * static_cast<std::size_t>(map_size_.width) + static_cast<std::size_t>(cell.x())];
+    if (t == id)
+        return;
+    t = id;
+    chunks_[static_cast<std::size_t>(cell.y() / chunk_tiles_) * static_cast<std::size_t>(chunks_size_.width) + static_cast<std::size_t>(cell.x() / chunk_tiles_)].dirty = true;
+}
+
+void tilemap::fill(rect<int> const& area, tile_id const id) noexcept {
+    auto const x0 = std::max(area.x(), 0), y0 = std::max(area.y(), 0);
+    auto const x1 = std::min(area.x() + area.w(), map_size_.width), y1 = std::min(area.y() + area.h(), map_size_.height);
+    for (int y = y0; y < y1; ++y) {
+        for (int x = x0; x < x1; ++x)
+            set_tile({x, y}, id);
+    }
+}
+
+void tilemap::invalidate() noexcept {
+    for (auto& c : chunks_)
+        c.dirty = true;
+}
+
+bool tilemap::acquire_texture(std::size_t const index) noexcept {
+    auto& c = chunks_[index];
+    if (c.txr)
+        return true;
+
+    // take the texture of the chunk drawn longest ago, unless it was drawn this frame
+    if (cached_.size() >= max_cached_chunks_ && !cached_.empty()) {
+        auto const oldest = std::min_element(cached_.begin(), cached_.end(), [this](std::size_t const a, std::size_t const b) {
+            return chunks_[a].last_drawn < chunks_[b].last_drawn;
+        });
+        if (chunks_[*oldest].last_drawn < frame_) {
+            c.txr.emplace(std::move(*chunks_[*oldest].txr));
+            chunks_[*oldest].txr.reset();
+            chunks_[*oldest].dirty = true;
+            *oldest = index;
+            c.dirty = true;
+            return true;
+        }
+    }
+
+    c.txr.emplace(renderer_, pixel_format_enum::ARGB8888, texture_access::TARGET, wh<int>{chunk_tiles_ * tile_size_.width, chunk_tiles_ * tile_size_.height});
+    if (!*c.txr) {
+        c.txr.reset();
+        return false;
+    }
+    c.dirty = true;
+    cached_.push_back(index);
+    return true;
+}
+
+bool tilemap::render_chunk(std::size_t const index) noexcept {
+    auto& c = chunks_[index];
+    auto const cx = static_cast<int>(index % static_cast<std::size_t>(chunks_size_.width)) * chunk_tiles_;
+    auto const cy = static_cast<int>(index / static_cast<std::size_t>(chunks_size_.width)) * chunk_tiles_;
+    auto const w = std::min(chunk_tiles_, map_size_.width - cx), h = std::min(chunk_tiles_, map_size_.height - cy);
+
+    render_state_guard const guard{renderer_};
+    if (!renderer_.set_render_target(*c.txr) || !renderer_.set_draw_color({0, 0, 0, 0}) || !renderer_.clear())
+        return false;
+
+    // tiles are copied as they are and the chunk blended like the tileset when drawn; blending them here
+    // too would leave the chunk premultiplied and blend its alpha twice
+    auto const tileset_blend = tileset_.blend_mode();
+    if (!tileset_.set_blend_mode(blend_mode::NONE))
+        return false;
+
+    bool ok = true;
+    for (int y = 0; y < h; ++y) {
+        auto const* const row = tiles_.data() + static_cast<std::size_t>(cy + y) * static_cast<std::size_t>(map_size_.width) + static_cast<std::size_t>(cx);
+        for (int x = 0; x < w; ++x) {
+            if (row[x] == no_tile)
+                continue;
+            rect<int> const src{(row[x] % tileset_columns_) * tile_size_.width, (row[x] / tileset_columns_) * tile_size_.height, tile_size_.width, tile_size_.height};
+            ok = renderer_.copy({x * tile_size_.width, y * tile_size_.height, tile_size_.width, tile_size_.height}, tileset_, src) && ok;
+            ++stats_.tiles_rendered;
+        }
+    }
+    tileset_.set_blend_mode(tileset_blend);
+    c.dirty = !ok;
+    ++stats_.chunks_rendered;
+    return ok;
+}
+
+bool tilemap::draw(point<int> const camera) noexcept {
+    ++frame_;
+    stats_ = {};
+
+    auto const view = renderer_.viewport();
+    auto const chunk_w = chunk_tiles_ * tile_size_.width, chunk_h = chunk_tiles_ * tile_size_.height;
+    auto const floor_div = [](int const a, int const b) { return a >= 0 ? a / b : -ceil_div(-a, b); };
+    auto const x0 = std::max(floor_div(camera.x(), chunk_w), 0);
+    auto const y0 = std::max(floor_div(camera.y(), chunk_h), 0);
+    auto const x1 = std::min(ceil_div(std::max(camera.x() + view.w(), 0), chunk_w), chunks_size_.width);
+    auto const y1 = std::min(ceil_div(std::max(camera.y() + view.h(), 0), chunk_h), chunks_size_.height);
+
+    bool ok = true;
+    for (int cy = y0; cy < y1; ++cy) {
+        for (int cx = x0; cx < x1; ++cx) {
+            auto const index = static_cast<std::size_t>(cy) * static_cast<std::size_t>(chunks_size_.width) + static_cast<std::size_t>(cx);
+            if (!acquire_texture(index) || (chunks_[index].dirty && !render_chunk(index))) {
+                ok = false;
+                continue;
+            }
+
+            auto& c = chunks_[index];
+            c.last_drawn = frame_;
+            auto const w = std::min(chunk_tiles_, map_size_.width - cx * chunk_tiles_) * tile_size_.width;
+            auto const h = std::min(chunk_tiles_, map_size_.height - cy * chunk_tiles_) * tile_size_.height;
+            ok = c.txr->set_blend_mode(tileset_.blend_mode()) && renderer_.copy({cx * chunk_w - camera.x(), cy * chunk_h - camera.y(), w, h}, *c.txr, {0, 0, w, h}) && ok;
+            ++stats_.chunks_drawn;
+        }
+    }
+    stats_.cached_chunks = cached_.size();
+    return ok;
+}
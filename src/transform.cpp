@@ -0,0 +1,440 @@
+#include "sdl2pp/transform.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+#include "parallel.hpp"
+#include "pixel_access.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SDL2PP_TRANSFORM_SSE2 1
+#endif
+
+using namespace sdl2;
+
+namespace {
+
+// the edge of the square blocks a transpose walks, in pixels: 64 rows of 256 bytes stay in L1
+constexpr int block = 64;
+
+/**
+ * @brief Pixels addressed by a first row and a pitch, which is negative to walk the rows bottom up.
+ */
+template<int Bytes>
+struct pixel_view {
+    std::uint8_t* data = nullptr;
+    std::ptrdiff_t pitch = 0;
+
+    std::uint8_t* at(int const x, int const y) const noexcept {
+        return data + static_cast<std::ptrdiff_t>(y) * pitch + static_cast<std::ptrdiff_t>(x) * Bytes;
+    }
+};
+
+template<int Bytes>
+void swap_pixels(std::uint8_t* const a, std::uint8_t* const b) noexcept {
+    std::array<std::uint8_t, Bytes> t;
+    std::memcpy(t.data(), a, Bytes);
+    std::memcpy(a, b, Bytes);
+    std::memcpy(b, t.data(), Bytes);
+}
+
+/**
+ * @brief Loads an n x n tile of pixels and stores it transposed. Loading before storing lets two tiles
+ * mirrored across the diagonal trade places.
+ */
+template<int Bytes>
+struct tile_ops {
+    static constexpr int n = 4;
+    using tile = std::array<std::uint8_t, n * n * Bytes>;
+
+    static tile load(std::uint8_t const* const p, std::ptrdiff_t const pitch) noexcept {
+        tile t;
+        for (int r = 0; r < n; ++r)
+            std::memcpy(t.data() + r * n * Bytes, p + r * pitch, n * Bytes);
+        return t;
+    }
+
+    static void store_transposed(tile const& t, std::uint8_t* const p, std::ptrdiff_t const pitch) noexcept {
+        for (int r = 0; r < n; ++r) {
+            for (int c = 0; c < n; ++c)
+                std::memcpy(p + r * pitch + c * Bytes, t.data() + (c * n + r) * Bytes, Bytes);
+        }
+    }
+};
+
+#ifdef SDL2PP_TRANSFORM_SSE2
+template<>
+struct tile_ops<4> {
+    static constexpr int n = 4;
+    struct tile {
+        __m128i rows[4];
+    };
+
+    static tile load(std::uint8_t const* const p, std::ptrdiff_t const pitch) noexcept {
+        tile t{};
+        for (int r = 0; r < n; ++r)
+            t.rows[static_cast<std::size_t>(r)] = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + r * pitch));
+        return t;
+    }
+
+    static void store_transposed(tile const& t, std::uint8_t* const p, std::ptrdiff_t const pitch) noexcept {
+        auto const a0 = _mm_unpacklo_epi32(t.rows[0], t.rows[1]), a1 = _mm_unpacklo_epi32(t.rows[2], t.rows[3]);
+        auto const a2 = _mm_unpackhi_epi32(t.rows[0], t.rows[1]), a3 = _mm_unpackhi_epi32(t.rows[2], t.rows[3]);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm_unpacklo_epi64(a0, a1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p + pitch), _mm_unpackhi_epi64(a0, a1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p + 2 * pitch), _mm_unpacklo_epi64(a2, a3));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p + 3 * pitch), _mm_unpackhi_epi64(a2, a3));
+    }
+};
+
+template<>
+struct tile_ops<2> {
+    static constexpr int n = 8;
+    struct tile {
+        __m128i rows[8];
+    };
+
+    static tile load(std::uint8_t const* const p, std::ptrdiff_t const pitch) noexcept {
+        tile t{};
+        for (int r = 0; r < n; ++r)
+            t.rows[static_cast<std::size_t>(r)] = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + r * pitch));
+        return t;
+    }
+
+    static void store_transposed(tile const& t, std::uint8_t* const p, std::ptrdiff_t const pitch) noexcept {
+        // interleave 16-bit pairs of rows, then 32-bit pairs of those, then 64-bit halves into columns
+        __m128i a[8], b[8];
+        for (std::size_t i = 0; i < 4; ++i) {
+            a[2 * i] = _mm_unpacklo_epi16(t.rows[2 * i], t.rows[2 * i + 1]);
+            a[2 * i + 1] = _mm_unpackhi_epi16(t.rows[2 * i], t.rows[2 * i + 1]);
+        }
+        for (std::size_t i = 0; i < 2; ++i) {
+            b[4 * i] = _mm_unpacklo_epi32(a[4 * i], a[4 * i + 2]);
+            b[4 * i + 1] = _mm_unpackhi_epi32(a[4 * i], a[4 * i + 2]);
+            b[4 * i + 2] = _mm_unpacklo_epi32(a[4 * i + 1], a[4 * i + 3]);
+            b[4 * i + 3] = _mm_unpackhi_epi32(a[4 * i + 1], a[4 * i + 3]);
+        }
+        for (std::size_t i = 0; i < 4; ++i) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(p + static_cast<std::ptrdiff_t>(2 * i) * pitch), _mm_unpacklo_epi64(b[i], b[i + 4]));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(p + static_cast<std::ptrdiff_t>(2 * i + 1) * pitch), _mm_unpackhi_epi64(b[i], b[i + 4]));
+        }
+    }
+};
+
+template<>
+struct tile_ops<1> {
+    static constexpr int n = 8;
+    struct tile {
+        __m128i rows[8];
+    };
+
+    static tile load(std::uint8_t const* const p, std::ptrdiff_t const pitch) noexcept {
+        tile t{};
+        for (int r = 0; r < n; ++r)
+            t.rows[static_cast<std::size_t>(r)] = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(p + r * pitch));
+        return t;
+    }
+
+    static void store_transposed(tile const& t, std::uint8_t* const p, std::ptrdiff_t const pitch) noexcept {
+        // interleave bytes, 16-bit and 32-bit pairs of rows; each result holds two columns
+        __m128i a[4], b[4];
+        for (std::size_t i = 0; i < 4; ++i)
+            a[i] = _mm_unpacklo_epi8(t.rows[2 * i], t.rows[2 * i + 1]);
+        b[0] = _mm_unpacklo_epi16(a[0], a[1]);
+        b[1] = _mm_unpackhi_epi16(a[0], a[1]);
+        b[2] = _mm_unpacklo_epi16(a[2], a[3]);
+        b[3] = _mm_unpackhi_epi16(a[2], a[3]);
+        __m128i const columns[]{_mm_unpacklo_epi32(b[0], b[2]), _mm_unpackhi_epi32(b[0], b[2]),
+                                 _mm_unpacklo_epi32(b[1], b[3]), _mm_unpackhi_epi32(b[1], b[3])};
+        for (std::size_t i = 0; i < 4; ++i) {
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(p + static_cast<std::ptrdiff_t>(2 * i) * pitch), columns[i]);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(p + static_cast<std::ptrdiff_t>(2 * i + 1) * pitch), _mm_unpackhi_epi64(columns[i], columns[i]));
+        }
+    }
+};
+#endif
+
+// Transposes the column blocks [begin, end) of a width x height src into dst, block by block, with full
+// tiles in registers and the ragged edges of each block pixel by pixel.
+template<int Bytes>
+void transpose_blocks(pixel_view<Bytes> const src, pixel_view<Bytes> const dst, int const width, int const height, int const begin, int const end) noexcept {
+    using ops = tile_ops<Bytes>;
+    constexpr int n = ops::n;
+    for (int bx = begin; bx < end; ++bx) {
+        auto const x0 = bx * block, x1 = std::min(x0 + block, width);
+        auto const xfull = x0 + (x1 - x0) / n * n;
+        for (int y0 = 0; y0 < height; y0 += block) {
+            auto const y1 = std::min(y0 + block, height);
+            auto const yfull = y0 + (y1 - y0) / n * n;
+            for (int y = y0; y < yfull; y += n) {
+                for (int x = x0; x < xfull; x += n)
+                    ops::store_transposed(ops::load(src.at(x, y), src.pitch), dst.at(y, x), dst.pitch);
+            }
+            for (int y = y0; y < y1; ++y) {
+                for (int x = y < yfull ? xfull : x0; x < x1; ++x)
+                    std::memcpy(dst.at(y, x), src.at(x, y), Bytes);
+            }
+        }
+    }
+}
+
+// Transposes a square in place over the block rows [begin, end): each block on or right of the diagonal
+// trades tiles with its mirror, so different block rows never touch the same pixels.
+template<int Bytes>
+void transpose_square_blocks(pixel_view<Bytes> const s, int const side, int const begin, int const end) noexcept {
+    using ops = tile_ops<Bytes>;
+    constexpr int n = ops::n;
+    for (int by = begin; by < end; ++by) {
+        auto const y0 = by * block, y1 = std::min(y0 + block, side);
+        for (int x0 = y0; x0 < side; x0 += block) {
+            auto const x1 = std::min(x0 + block, side);
+            for (int y = y0; y + n <= y1; y += n) {
+                for (int x = x0 == y0 ? y : x0; x + n <= x1; x += n) {
+                    auto const a = ops::load(s.at(x, y), s.pitch);
+                    auto const b = ops::load(s.at(y, x), s.pitch);
+                    ops::store_transposed(a, s.at(y, x), s.pitch);
+                    ops::store_transposed(b, s.at(x, y), s.pitch);
+                }
+            }
+        }
+    }
+}
+
+template<int Bytes>
+void transpose_square(pixel_view<Bytes> const s, int const side, std::size_t const threads) {
+    auto const blocks = (side + block - 1) / block;
+    detail::parallel_rows(blocks, static_cast<std::size_t>(block) * static_cast<std::size_t>(side), threads, [&](int const begin, int const end) {
+        transpose_square_blocks(s, side, begin, end);
+    });
+    // the last side % n rows and columns are left to swap one pixel at a time
+    auto const full = side / tile_ops<Bytes>::n * tile_ops<Bytes>::n;
+    for (int y = 0; y < side; ++y) {
+        for (int x = std::max(y + 1, full); x < side; ++x)
+            swap_pixels<Bytes>(s.at(x, y), s.at(y, x));
+    }
+}
+
+/**
+ * @brief Reverses the order of n pixels in a register.
+ */
+template<int Bytes>
+struct reverse_ops {
+    static constexpr int n = 0;
+};
+
+#ifdef SDL2PP_TRANSFORM_SSE2
+template<>
+struct reverse_ops<4> {
+    static constexpr int n = 4;
+    static __m128i reverse(__m128i const v) noexcept {
+        return _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3));
+    }
+};
+
+template<>
+struct reverse_ops<2> {
+    static constexpr int n = 8;
+    static __m128i reverse(__m128i const v) noexcept {
+        auto const halves = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3)), _MM_SHUFFLE(0, 1, 2, 3));
+        return _mm_shuffle_epi32(halves, _MM_SHUFFLE(1, 0, 3, 2));
+    }
+};
+
+template<>
+struct reverse_ops<1> {
+    static constexpr int n = 16;
+    static __m128i reverse(__m128i const v) noexcept {
+        return reverse_ops<2>::reverse(_mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8)));
+    }
+};
+#endif
+
+// Mirrors a row in place, swapping registers of pixels from both ends towards the middle.
+template<int Bytes>
+void reverse_row(std::uint8_t* const row, int const width) noexcept {
+    int i = 0, j = width;
+#ifdef SDL2PP_TRANSFORM_SSE2
+    if constexpr (reverse_ops<Bytes>::n > 0) {
+        using ops = reverse_ops<Bytes>;
+        for (; j - i >= 2 * ops::n; i += ops::n, j -= ops::n) {
+            auto* const left = reinterpret_cast<__m128i*>(row + i * Bytes);
+            auto* const right = reinterpret_cast<__m128i*>(row + (j - ops::n) * Bytes);
+            auto const a = _mm_loadu_si128(left), b = _mm_loadu_si128(right);
+            _mm_storeu_si128(left, ops::reverse(b));
+            _mm_storeu_si128(right, ops::reverse(a));
+        }
+    }
+#endif
+    for (--j; i < j; ++i, --j)
+        swap_pixels<Bytes>(row + i * Bytes, row + j * Bytes);
+}
+
+template<int Bytes>
+void flip_rows(pixel_view<Bytes> const s, int const width, int const height, renderer_flip const direction) noexcept {
+    if (direction & renderer_flip::VERTICAL) {
+        auto const row_bytes = static_cast<std::size_t>(width) * Bytes;
+        for (int y = 0; y < height / 2; ++y)
+            std::swap_ranges(s.at(0, y), s.at(0, y) + row_bytes, s.at(0, height - 1 - y));
+    }
+    if (direction & renderer_flip::HORIZONTAL) {
+        for (int y = 0; y < height; ++y)
+            reverse_row<Bytes>(s.at(0, y), width);
+    }
+}
+
+// calls f with the pixel size as a std::integral_constant, or returns false for formats the kernels do not handle
+template<class F>
+bool with_pixel_size(surface const& s, F const& f) {
+    if (!s)
+        return false;
+    auto const fmt = s.pixel_format();
+    if (is_pixel_format_four_cc(fmt.format()) || fmt.bits_per_pixel() < 8)
+        return false;
+    switch (fmt.bytes_per_pixel()) {
+    case 1: return f(std::integral_constant<int, 1>{});
+    case 2: return f(std::integral_constant<int, 2>{});
+    case 3: return f(std::integral_constant<int, 3>{});
+    case 4: return f(std::integral_constant<int, 4>{});
+    default: return false;
+    }
+}
+
+template<int Bytes>
+pixel_view<Bytes> view_of(surface const& s) noexcept {
+    return {reinterpret_cast<std::uint8_t*>(const_cast<void*>(s.pixels())), s.pitch()};
+}
+
+// the same view, walking the rows bottom up
+template<int Bytes>
+pixel_view<Bytes> bottom_up(pixel_view<Bytes> const v, int const height) noexcept {
+    return {v.at(0, height - 1), -v.pitch};
+}
+
+// a surface of the given size with the format, palette and blit settings of s
+surface blank_like(surface const& s, wh<int> const size) noexcept {
+    auto const fmt = s.pixel_format();
+    surface out{fmt.format(), fmt.bits_per_pixel(), size};
+    if (!out)
+        return out;
+    if (fmt.has_palette() && !out.set_palette(palette_view{*fmt.palette().native_handle()}))
+        return surface{nullptr};
+    if (auto const key = s.color_key())
+        out.set_color_key(true, *key);
+    out.set_blend_mode(s.blend_mode());
+    out.set_alpha_mod(s.alpha_mod());
+    out.set_color_mode(s.color_mod());
+    return out;
+}
+
+// Transposes s into a new surface. A quarter turn clockwise is the transpose of s read bottom up, and
+// one anticlockwise the transpose written bottom up; anything else is a plain transpose.
+surface transposed_copy(surface const& s, rotation const r, std::size_t const threads) {
+    std::optional<surface> out;
+    auto const ok = with_pixel_size(s, [&]<int Bytes>(std::integral_constant<int, Bytes>) {
+        auto& copy = out.emplace(blank_like(s, {s.height(), s.width()}));
+        if (!copy)
+            return false;
+        detail::surface_lock_guard const lock_src{const_cast<surface&>(s)};
+        detail::surface_lock_guard const lock_dst{copy};
+        if (s.pixels() == nullptr || copy.pixels() == nullptr)
+            return false;
+
+        auto src = view_of<Bytes>(s);
+        auto dst = view_of<Bytes>(copy);
+        if (r == rotation::CW_90)
+            src = bottom_up(src, s.height());
+        else if (r == rotation::CW_270)
+            dst = bottom_up(dst, copy.height());
+        auto const blocks = (s.width() + block - 1) / block;
+        detail::parallel_rows(blocks, static_cast<std::size_t>(block) * static_cast<std::size_t>(s.height()), threads, [&](int const begin, int const end) {
+            transpose_blocks(src, dst, s.width(), s.height(), begin, end);
+        });
+        return true;
+    });
+    // a copy that failed part way has pixels that were never written, so only a finished one is returned
+    return ok ? std::move(*out) : surface{nullptr};
+}
+
+} // namespace
+
+bool sdl2::flip(surface& s, renderer_flip const direction) noexcept {
+    return with_pixel_size(s, [&]<int Bytes>(std::integral_constant<int, Bytes>) {
+        detail::surface_lock_guard const lock{s};
+        if (s.pixels() == nullptr)
+            return false;
+        flip_rows(view_of<Bytes>(s), s.width(), s.height(), direction);
+        return true;
+    });
+}
+
+surface sdl2::flipped(surface const& s, renderer_flip const direction) noexcept {
+    std::optional<surface> out;
+    auto const ok = with_pixel_size(s, [&]<int Bytes>(std::integral_constant<int, Bytes>) {
+        auto& copy = out.emplace(blank_like(s, {s.width(), s.height()}));
+        if (!copy)
+            return false;
+        detail::surface_lock_guard const lock_src{const_cast<surface&>(s)};
+        detail::surface_lock_guard const lock_dst{copy};
+        if (s.pixels() == nullptr || copy.pixels() == nullptr)
+            return false;
+
+        auto const src = view_of<Bytes>(s), dst = view_of<Bytes>(copy);
+        auto const rows = direction & renderer_flip::VERTICAL ? bottom_up(src, s.height()) : src;
+        for (int y = 0; y < s.height(); ++y) {
+            std::memcpy(dst.at(0, y), rows.at(0, y), static_cast<std::size_t>(s.width()) * Bytes);
+            if (direction & renderer_flip::HORIZONTAL)
+                reverse_row<Bytes>(dst.at(0, y), s.width());
+        }
+        return true;
+    });
+    return ok ? std::move(*out) : surface{nullptr};
+}
+
+bool sdl2::transpose(surface& s, std::size_t const threads) {
+    if (!s || s.width() != s.height())
+        return false;
+    return with_pixel_size(s, [&]<int Bytes>(std::integral_constant<int, Bytes>) {
+        detail::surface_lock_guard const lock{s};
+        if (s.pixels() == nullptr)
+            return false;
+        transpose_square(view_of<Bytes>(s), s.width(), threads);
+        return true;
+    });
+}
+
+surface sdl2::transposed(surface const& s, std::size_t const threads) {
+    return transposed_copy(s, rotation::NONE, threads);
+}
+
+bool sdl2::rotate(surface& s, rotation const r, std::size_t const threads) {
+    switch (r) {
+    case rotation::NONE:
+        return static_cast<bool>(s);
+    case rotation::CW_180:
+        return flip(s, renderer_flip::HORIZONTAL | renderer_flip::VERTICAL);
+    case rotation::CW_90:
+        return transpose(s, threads) && flip(s, renderer_flip::HORIZONTAL);
+    case rotation::CW_270:
+        return transpose(s, threads) && flip(s, renderer_flip::VERTICAL);
+    }
+    return false;
+}
+
+surface sdl2::rotated(surface const& s, rotation const r, std::size_t const threads) {
+    switch (r) {
+    case rotation::NONE:
+        return flipped(s, renderer_flip::NONE);
+    case rotation::CW_180:
+        return flipped(s, renderer_flip::HORIZONTAL | renderer_flip::VERTICAL);
+    case rotation::CW_90:
+    case rotation::CW_270:
+        return transposed_copy(s, r, threads);
+    }
+    return surface{nullptr};
+}
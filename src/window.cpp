@@ -238,5 +238,5 @@ bool window::update_surface() noexcept {
 }
 
 bool window::update_surface_rects(std::span<rect<int> const> const rects) noexcept {
-    return SDL_UpdateWindowSurfaceRects(window_, rects.data()->native_handle(), rects.size());
+    return SDL_UpdateWindowSurfaceRects(window_, rects.data()->native_handle(), static_cast<int>(rects.size())) == 0;
 }
\ No newline at end of file